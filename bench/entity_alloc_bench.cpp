@@ -0,0 +1,57 @@
+// Spawner throughput for EntityManager with 1..N threads, each allocating and
+// freeing ids through the shared stack directly and through a LocalCache.
+//
+//   make bench && ./bench/entity_alloc_bench [max_threads] [rounds]
+#include "../ecs/entity_manager.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+template<typename Spawn>
+double run(uint32_t threads, uint32_t rounds, Spawn spawn) {
+    auto manager = std::make_unique<EntityManager>();
+    uint32_t per_thread = MAX_ENTITIES / threads / 2; // never exhaust the pool
+
+    std::vector<std::thread> workers;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&] { spawn(*manager, per_thread, rounds); });
+    }
+    for (auto& worker : workers) worker.join();
+    auto stop_time = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop_time - start_time).count();
+    return 2.0 * threads * per_thread * rounds / seconds; // create + destroy
+}
+
+int main(int argc, char** argv) {
+    uint32_t max_threads = argc > 1 ? atoi(argv[1]) : std::thread::hardware_concurrency();
+    uint32_t rounds = argc > 2 ? atoi(argv[2]) : 2000;
+    if (max_threads == 0) max_threads = 1;
+
+    printf("%8s %16s %16s\n", "threads", "global ops/s", "cached ops/s");
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+        double global = run(threads, rounds, [](EntityManager& manager, uint32_t count, uint32_t rounds) {
+            std::vector<Entity> ids (count);
+            for (uint32_t r = 0; r < rounds; r++) {
+                for (auto& id : ids) id = manager.create_entity();
+                for (auto id : ids) manager.destroy_entity(id);
+            }
+        });
+
+        double cached = run(threads, rounds, [](EntityManager& manager, uint32_t count, uint32_t rounds) {
+            EntityManager::LocalCache cache (manager);
+            std::vector<Entity> ids (count);
+            for (uint32_t r = 0; r < rounds; r++) {
+                for (auto& id : ids) id = cache.create_entity();
+                for (auto id : ids) cache.destroy_entity(id);
+            }
+        });
+
+        printf("%8u %16.0f %16.0f\n", threads, global, cached);
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+}
@@ -0,0 +1,133 @@
+// Sharded world throughput with 1..N simulation processes on one box. Each
+// shard process moves its bodies, bounces them off the world's ends and
+// exchanges migrants and boundary state with its neighbours over shared
+// memory rings. Reported per shard count: body updates per second across
+// all processes, migrations per tick, and bodies lost (should be 0).
+//
+//   make bench && ./bench/shard_bench [max_shards] [ticks] [bodies_per_shard]
+#include "../ecs/shard.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct Body {
+    float x, y;
+    float vx, vy;
+};
+
+struct ShardStats {
+    uint64_t updates;
+    uint64_t sent;
+    uint64_t final_count;
+    double seconds;
+};
+
+constexpr float STRIP_WIDTH = 100.0f;
+
+static auto locate = [](Body const& body) { return std::pair<float, float>(body.x, body.y); };
+
+static void run_shard(uint32_t index, uint32_t count, uint32_t ticks, uint32_t bodies, ShardStats& stats) {
+    Shard<Body, decltype(locate)> shard ("shard_bench", index, count, STRIP_WIDTH, 2.0f, locate, [](Coordinator& world) {
+        world.register_component<Body>();
+    });
+    if (!shard.is_open()) {
+        fprintf(stderr, "shard %u: %s\n", index, shard.error.empty() ? "can't open rings" : shard.error.c_str());
+        _exit(1);
+    }
+
+    float extent = count * STRIP_WIDTH;
+    std::mt19937 random (index + 1);
+    std::uniform_real_distribution<float> x (shard.min_x(), shard.max_x());
+    std::uniform_real_distribution<float> velocity (-60.0f, 60.0f);
+    for (uint32_t i = 0; i < bodies; i++) {
+        Entity entity = shard.world.create_entity();
+        shard.world.add_component(entity, Body { x(random), 0.0f, velocity(random), velocity(random) });
+    }
+
+    const float dt = 1.0f / 60.0f;
+    uint64_t updates = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        ComponentArray<Body>& array = *shard.array;
+        for (size_t i = 0; i < array.size; i++) {
+            Body& body = array.component_array[i];
+            body.x += body.vx * dt;
+            body.y += body.vy * dt;
+            if (body.x < 0.0f || body.x >= extent) body.vx = -body.vx;
+        }
+        updates += array.size;
+        shard.exchange();
+    }
+    auto stop_time = std::chrono::high_resolution_clock::now();
+
+    stats.updates = updates;
+    stats.sent = shard.sent;
+    stats.final_count = shard.array->size;
+    stats.seconds = std::chrono::duration<double>(stop_time - start_time).count();
+}
+
+int main(int argc, char** argv) {
+    uint32_t max_shards = argc > 1 ? atoi(argv[1]) : std::thread::hardware_concurrency();
+    uint32_t ticks = argc > 2 ? atoi(argv[2]) : 2000;
+    uint32_t bodies = argc > 3 ? atoi(argv[3]) : 2000;
+    if (max_shards == 0) max_shards = 1;
+    if (bodies > MAX_ENTITIES / 2) bodies = MAX_ENTITIES / 2; // room for arrivals
+
+    auto stats = static_cast<ShardStats*>(mmap(nullptr, sizeof(ShardStats) * max_shards, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (stats == MAP_FAILED) return 1;
+
+    printf("%8s %16s %14s %8s\n", "shards", "updates/s", "moved/tick", "lost");
+    for (uint32_t count = 1; count <= max_shards; count *= 2) {
+        auto rings = create_shard_rings("shard_bench", count);
+
+        std::vector<pid_t> children;
+        for (uint32_t i = 0; i < count; i++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                run_shard(i, count, ticks, bodies, stats[i]);
+                _exit(0); // skip destructors, the rings belong to the parent
+            }
+            children.push_back(pid);
+        }
+
+        bool failed = false;
+        for (pid_t pid : children) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+        if (failed) {
+            fprintf(stderr, "a shard process failed\n");
+            return 1;
+        }
+
+        // Migrants still in flight when their receiver stopped.
+        uint64_t in_flight = 0;
+        std::vector<uint8_t> message;
+        for (uint32_t i = 0; i + 1 < count; i++) {
+            for (uint32_t from : { i, i + 1 }) {
+                SharedRing ring (shard_ring_name("shard_bench", from, from == i ? i + 1 : i, 'm').c_str());
+                while (ring.is_open() && ring.pop(message)) in_flight++;
+            }
+        }
+
+        uint64_t updates = 0, sent = 0, total = in_flight;
+        double slowest = 0.0;
+        for (uint32_t i = 0; i < count; i++) {
+            updates += stats[i].updates;
+            sent += stats[i].sent;
+            total += stats[i].final_count;
+            if (stats[i].seconds > slowest) slowest = stats[i].seconds;
+        }
+        long long lost = static_cast<long long>(count) * bodies - static_cast<long long>(total);
+        printf("%8u %16.0f %14.2f %8lld\n", count, updates / slowest, double(sent) / ticks, lost);
+
+        if (count < max_shards && count * 2 > max_shards) count = max_shards / 2;
+    }
+    munmap(stats, sizeof(ShardStats) * max_shards);
+}
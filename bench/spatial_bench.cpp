@@ -0,0 +1,88 @@
+// Crowd separation on a SpatialWorld grid with 1..N job workers. Every body
+// is pushed away from neighbours in its own cell and in the halo, then moved,
+// so bodies keep crossing cell borders and get migrated each tick.
+//
+//   make bench && ./bench/spatial_bench [max_workers] [ticks] [grid_side]
+#include "../ecs/spatial_world.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+struct Body {
+    float x, y;
+    float vx, vy;
+};
+
+constexpr float CELL_SIZE = 20.0f;
+constexpr float RADIUS = 1.0f;
+constexpr uint32_t BODIES_PER_CELL = 400;
+
+static auto locate = [](Body const& body) { return std::pair<float, float>(body.x, body.y); };
+using World = SpatialWorld<Body, decltype(locate)>;
+
+static void push_apart(Body& body, Body const& other) {
+    float dx = body.x - other.x;
+    float dy = body.y - other.y;
+    float d2 = dx * dx + dy * dy;
+    if (d2 > 0.0f && d2 < 4.0f * RADIUS * RADIUS) {
+        body.vx += dx / d2 * 0.01f;
+        body.vy += dy / d2 * 0.01f;
+    }
+}
+
+static void separate(World::Cell& cell, float dt, float side) {
+    ComponentArray<Body>& bodies = *cell.array;
+    for (size_t i = 0; i < bodies.size; i++) {
+        Body& body = bodies.component_array[i];
+        for (size_t j = 0; j < bodies.size; j++) push_apart(body, bodies.component_array[j]);
+        for (Body const& other : cell.halo) push_apart(body, other);
+    }
+    for (size_t i = 0; i < bodies.size; i++) {
+        Body& body = bodies.component_array[i];
+        body.x += body.vx * dt;
+        body.y += body.vy * dt;
+        if (body.x < 0.0f || body.x >= side) body.vx = -body.vx;
+        if (body.y < 0.0f || body.y >= side) body.vy = -body.vy;
+    }
+}
+
+static void run(uint32_t workers, uint32_t ticks, uint32_t side) {
+    World world (side, side, CELL_SIZE, 2.0f * RADIUS, locate, [](Coordinator& cell) {
+        cell.register_component<Body>();
+    });
+    float extent = side * CELL_SIZE;
+
+    std::mt19937 random (7);
+    std::uniform_real_distribution<float> position (0.0f, extent);
+    std::uniform_real_distribution<float> velocity (-5.0f, 5.0f);
+    for (uint32_t i = 0; i < side * side * BODIES_PER_CELL; i++) {
+        world.create_entity({ position(random), position(random), velocity(random), velocity(random) });
+    }
+
+    JobSystem jobs (workers);
+    world.exchange(jobs);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        world.step(jobs, 1.0f / 60.0f, [&](World::Cell& cell, float dt) { separate(cell, dt, extent); });
+    }
+    auto stop_time = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop_time - start_time).count();
+    printf("%8u %8zu %12.1f %12.2f\n", workers, world.cell_count(), ticks / seconds, double(world.migrated) / ticks);
+}
+
+int main(int argc, char** argv) {
+    uint32_t max_workers = argc > 1 ? atoi(argv[1]) : std::thread::hardware_concurrency();
+    uint32_t ticks = argc > 2 ? atoi(argv[2]) : 200;
+    uint32_t side = argc > 3 ? atoi(argv[3]) : 8;
+    if (max_workers == 0) max_workers = 1;
+
+    printf("%8s %8s %12s %12s\n", "workers", "cells", "ticks/s", "moved/tick");
+    for (uint32_t workers = 1; workers <= max_workers; workers *= 2) {
+        run(workers, ticks, side);
+        if (workers < max_workers && workers * 2 > max_workers) workers = max_workers / 2;
+    }
+}
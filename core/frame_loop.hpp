@@ -0,0 +1,169 @@
+#pragma once
+#include "memory.hpp"
+#include "jobs.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+// Keeps the previous and current simulation value so the renderer can draw
+// somewhere in between. Works for anything with +, - and scalar * (floats,
+// glm vectors and matrices).
+template<typename T>
+struct Interpolated {
+    T previous;
+    T current;
+
+    void reset(const T& value) {
+        previous = value;
+        current = value;
+    }
+
+    void push(const T& next) {
+        previous = current;
+        current = next;
+    }
+
+    // Start of a tick where current is then updated in place.
+    void save() {
+        previous = current;
+    }
+
+    T blend(float alpha) const {
+        return previous + (current - previous) * alpha;
+    }
+};
+
+// Two copies of what the renderer reads. Simulation side fills back() while
+// render draws front(); publish() flips them once both sides are done.
+template<typename T>
+class DoubleBuffered {
+    public:
+        T& back() {
+            return buffers[1 - current];
+        }
+
+        T const& front() const {
+            return buffers[current];
+        }
+
+        void publish() {
+            current = 1 - current;
+        }
+
+    private:
+        T buffers[2];
+        int current = 0;
+};
+
+// Runs simulation at a fixed tick and rendering at whatever rate the
+// swapchain allows. Real time is banked into an accumulator and drained in
+// whole ticks; the remainder becomes the interpolation factor handed to render.
+class FrameLoop {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        FrameLoop(double tick_rate = 60.0, uint32_t max_ticks_per_frame = 5) {
+            tick_dt = 1.0 / tick_rate;
+            this->max_ticks_per_frame = max_ticks_per_frame;
+        }
+
+        // Call right before entering the loop so init time isn't simulated.
+        void start() {
+            last_time = Clock::now();
+            accumulator = 0.0;
+        }
+
+        template<typename Simulate, typename Render>
+        void frame(Simulate&& simulate, Render&& render) {
+            if (frame_allocator) frame_allocator->reset();
+
+            uint32_t steps = take_ticks();
+            for (uint32_t i = 0; i < steps; i++) {
+                simulate(static_cast<float>(tick_dt));
+                tick++;
+            }
+
+            render(alpha());
+        }
+
+        // Pipelined frame: this frame's ticks run as a job and finish by
+        // extracting into snapshots.back(), while render draws
+        // snapshots.front() from the previous frame. Frame time tends to
+        // max(sim, render) instead of their sum, at one frame of latency.
+        // Render must only read its snapshot; the frame allocator belongs to
+        // the simulation side.
+        template<typename Snapshot, typename Simulate, typename Extract, typename Render>
+        void frame(JobSystem& jobs, DoubleBuffered<Snapshot>& snapshots, Simulate&& simulate, Extract&& extract, Render&& render) {
+            if (frame_allocator) frame_allocator->reset();
+
+            // The job captures one pointer so std::function keeps it inline
+            // instead of allocating.
+            struct Work {
+                uint32_t steps;
+                float alpha;
+                float dt;
+                Simulate& simulate;
+                Extract& extract;
+                Snapshot& snapshot;
+            } work { take_ticks(), alpha(), static_cast<float>(tick_dt), simulate, extract, snapshots.back() };
+            uint32_t steps = work.steps;
+
+            JobCounter ticks;
+            Work* shared = &work;
+            jobs.run(Job { [shared] {
+                for (uint32_t i = 0; i < shared->steps; i++) shared->simulate(shared->dt);
+                shared->extract(shared->snapshot, shared->alpha);
+            }, "simulate" }, &ticks);
+
+            render(snapshots.front());
+            jobs.wait(ticks);
+            tick += steps;
+            snapshots.publish();
+        }
+
+        // Batch mode: no render, no clock, just ticks back to back. Each tick
+        // counts as a frame for the frame allocator.
+        template<typename Simulate>
+        void run_headless(uint64_t ticks, Simulate&& simulate) {
+            for (uint64_t i = 0; i < ticks; i++) {
+                if (frame_allocator) frame_allocator->reset();
+                simulate(static_cast<float>(tick_dt));
+                tick++;
+            }
+        }
+
+        float alpha() const {
+            return static_cast<float>(accumulator / tick_dt);
+        }
+
+        double tick_dt;
+        uint32_t max_ticks_per_frame;
+        uint64_t tick = 0;
+        uint64_t dropped_ticks = 0;
+        LinearAllocator* frame_allocator = nullptr; // rewound at the start of every frame
+
+    private:
+        // Banks elapsed time and returns how many ticks this frame owes.
+        // Catch-up is capped; whatever we couldn't afford is dropped rather
+        // than carried forward, otherwise a slow frame snowballs.
+        uint32_t take_ticks() {
+            auto now = Clock::now();
+            accumulator += std::chrono::duration<double>(now - last_time).count();
+            last_time = now;
+
+            uint32_t steps = 0;
+            while (accumulator >= tick_dt && steps < max_ticks_per_frame) {
+                accumulator -= tick_dt;
+                steps++;
+            }
+
+            if (accumulator >= tick_dt) {
+                dropped_ticks += static_cast<uint64_t>(accumulator / tick_dt);
+                accumulator = std::fmod(accumulator, tick_dt);
+            }
+            return steps;
+        }
+
+        Clock::time_point last_time = Clock::now();
+        double accumulator = 0.0;
+};
@@ -0,0 +1,226 @@
+#include "jobs.hpp"
+#include <assert.h>
+#include <ucontext.h>
+
+struct Fiber {
+    enum class State { IDLE, RUNNING, WAITING, FINISHED };
+
+    ucontext_t context;
+    std::unique_ptr<char[]> stack;
+    JobSystem* system;
+    void* worker = nullptr; // worker currently running this fiber
+    ucontext_t* scheduler = nullptr;
+    uint32_t worker_index = 0;
+    State state = State::IDLE;
+
+    Job job;
+    JobCounter* counter = nullptr;
+    JobCounter* wait_counter = nullptr;
+    int wait_target = 0;
+    Fiber* next_waiter = nullptr; // in wait_counter's waiters, or a resume list
+};
+
+// Only read right before a switch; the compiler may cache a TLS address
+// across swapcontext, and a fiber can come back on another thread.
+static thread_local Fiber* running_fiber = nullptr;
+
+__attribute__((noinline)) static Fiber* current_fiber() {
+    return running_fiber;
+}
+
+JobSystem::JobSystem(uint32_t worker_count, uint32_t fiber_count, size_t stack_size) {
+    this->worker_count = worker_count ? worker_count : 1;
+    this->stack_size = stack_size;
+
+    for (uint32_t i = 0; i < fiber_count; i++) free_fibers.push_back(create_fiber());
+
+    for (uint32_t i = 0; i < this->worker_count; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->system = this;
+        worker->index = i;
+        workers.push_back(std::move(worker));
+    }
+    for (auto& worker : workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([this, w] { worker_main(*w); });
+    }
+}
+
+// Kept out of line so getcontext's returns-twice semantics can't clobber a
+// caller's loop variables.
+__attribute__((noinline)) Fiber* JobSystem::create_fiber() {
+    Fiber* fiber = fiber_pool.create();
+    fiber->system = this;
+    fiber->stack = std::make_unique<char[]>(stack_size);
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = fiber->stack.get();
+    fiber->context.uc_stack.ss_size = stack_size;
+    fiber->context.uc_link = nullptr;
+    makecontext(&fiber->context, &JobSystem::fiber_main, 0);
+    fibers.push_back(fiber);
+    return fiber;
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker->thread.join();
+    for (Fiber* fiber : fibers) fiber_pool.destroy(fiber);
+}
+
+void JobSystem::run(Job const* new_jobs, size_t count, JobCounter* counter) {
+    if (counter) counter->count.fetch_add(static_cast<int>(count), std::memory_order_acq_rel);
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        for (size_t i = 0; i < count; i++) jobs.push_back({ new_jobs[i], counter });
+    }
+    if (count == 1) wake.notify_one();
+    else wake.notify_all();
+}
+
+void JobSystem::wait(JobCounter& counter, int target) {
+    Fiber* self = current_fiber();
+    {
+        // Checked under the counter's lock even when it's already done: the
+        // caller may destroy counter as soon as we return, so the finishing
+        // job has to be out of it first.
+        std::unique_lock<std::mutex> lock (counter.mutex);
+        if (counter.value() <= target) return;
+        if (!self) {
+            counter.done.wait(lock, [&] { return counter.value() <= target; });
+            return;
+        }
+    }
+
+    // The scheduler registers us with the counter once we're off this
+    // stack, so a finishing job can't resume the fiber while it still runs.
+    self->state = Fiber::State::WAITING;
+    self->wait_counter = &counter;
+    self->wait_target = target;
+    swapcontext(&self->context, self->scheduler);
+}
+
+void JobSystem::fiber_main() {
+    Fiber* self = current_fiber();
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        self->job.function();
+        auto end = std::chrono::steady_clock::now();
+
+        JobSystem* system = self->system;
+        if (system->on_job_finished) system->on_job_finished({ self->job.name, self->worker_index, start, end });
+        system->finish(self->counter);
+
+        self->state = Fiber::State::FINISHED;
+        swapcontext(&self->context, self->scheduler);
+    }
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (!counter) return;
+
+    // Fibers are only handed to workers after the counter is unlocked, since
+    // a resumed waiter may destroy it straight away. They're relinked onto a
+    // local list rather than collected, so finishing never allocates.
+    Fiber* resumed = nullptr;
+    {
+        std::lock_guard<std::mutex> counter_lock (counter->mutex);
+        int value = counter->count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        Fiber** link = &counter->waiters;
+        while (*link) {
+            Fiber* fiber = *link;
+            if (value <= fiber->wait_target) {
+                *link = fiber->next_waiter;
+                fiber->next_waiter = resumed;
+                resumed = fiber;
+            } else {
+                link = &fiber->next_waiter;
+            }
+        }
+        counter->done.notify_all();
+    }
+    if (!resumed) return;
+
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        while (resumed) {
+            Fiber* next = resumed->next_waiter; // the fiber may park again once queued
+            resumed->next_waiter = nullptr;
+            ready.push_back(resumed);
+            resumed = next;
+        }
+    }
+    wake.notify_all();
+}
+
+void JobSystem::park(Fiber* fiber) {
+    {
+        JobCounter& counter = *fiber->wait_counter;
+        std::lock_guard<std::mutex> counter_lock (counter.mutex);
+        if (counter.value() > fiber->wait_target) {
+            fiber->next_waiter = counter.waiters;
+            counter.waiters = fiber;
+            return;
+        }
+    }
+
+    // Finished while we were switching out.
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        ready.push_back(fiber);
+    }
+    wake.notify_one();
+}
+
+void JobSystem::worker_main(Worker& worker) {
+    ucontext_t scheduler;
+    worker.scheduler = &scheduler;
+
+    while (true) {
+        Fiber* fiber = nullptr;
+        {
+            std::unique_lock<std::mutex> lock (mutex);
+            wake.wait(lock, [&] { return stopping || !ready.empty() || !jobs.empty(); });
+            if (!ready.empty()) {
+                fiber = ready.front();
+                ready.pop_front();
+            } else if (!jobs.empty()) {
+                // Every fiber is running or parked in a wait. Waiters may
+                // depend on the queued jobs, so grow rather than stall.
+                if (free_fibers.empty()) {
+                    fiber = create_fiber();
+                } else {
+                    fiber = free_fibers.back();
+                    free_fibers.pop_back();
+                }
+                fiber->job = std::move(jobs.front().job);
+                fiber->counter = jobs.front().counter;
+                jobs.pop_front();
+            } else {
+                return; // stopping with nothing left to run
+            }
+        }
+
+        fiber->state = Fiber::State::RUNNING;
+        fiber->worker = &worker;
+        fiber->scheduler = &scheduler;
+        fiber->worker_index = worker.index;
+        running_fiber = fiber;
+        swapcontext(&scheduler, &fiber->context);
+        running_fiber = nullptr;
+
+        if (fiber->state == Fiber::State::WAITING) {
+            park(fiber);
+        } else {
+            fiber->job.function = nullptr;
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                free_fibers.push_back(fiber);
+            }
+            wake.notify_one();
+        }
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include "memory.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct Fiber;
+
+// FIFO over a power-of-two vector that only allocates when it has to grow,
+// so steady-state pushes and pops never reach malloc (a deque frees and
+// reallocates its blocks as the queue drains and refills).
+template<typename T>
+class RingQueue {
+    public:
+        bool empty() const {
+            return count == 0;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        T& front() {
+            return items[head];
+        }
+
+        void push_back(T item) {
+            if (count == items.size()) grow();
+            items[(head + count) & (items.size() - 1)] = std::move(item);
+            count++;
+        }
+
+        void pop_front() {
+            items[head] = T();
+            head = (head + 1) & (items.size() - 1);
+            count--;
+        }
+
+    private:
+        void grow() {
+            std::vector<T> larger (items.empty() ? 16 : items.size() * 2);
+            for (size_t i = 0; i < count; i++) larger[i] = std::move(items[(head + i) & (items.size() - 1)]);
+            items.swap(larger);
+            head = 0;
+        }
+
+        std::vector<T> items;
+        size_t head = 0;
+        size_t count = 0;
+};
+
+// Number of outstanding jobs started with it. Waiting on a counter from
+// inside a job parks the job's fiber and frees the worker thread for other
+// work; waiting from any other thread blocks that thread.
+class JobCounter {
+    public:
+        int value() const {
+            return count.load(std::memory_order_acquire);
+        }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<int> count { 0 };
+        std::mutex mutex;
+        std::condition_variable done;
+        Fiber* waiters = nullptr; // parked fibers, linked through Fiber::next_waiter
+};
+
+struct Job {
+    std::function<void()> function;
+    const char* name = "job";
+};
+
+struct JobTiming {
+    const char* name;
+    uint32_t worker;   // worker that finished the job
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end; // includes time parked in waits
+};
+
+// Worker threads running jobs on a fixed pool of ucontext fibers. Each job
+// gets a fiber for its whole life, so it can wait on counters mid-way and be
+// resumed later, possibly on another worker. Jobs shouldn't hold locks or
+// rely on thread_local across a wait. fiber_count fibers are made up front;
+// when all of them are busy or parked and jobs are queued, an idle worker
+// makes another, so the pool ends up as large as the most jobs ever waiting
+// at once plus the worker count. Fibers are kept until the system dies.
+class JobSystem {
+    public:
+        JobSystem(uint32_t worker_count = std::thread::hardware_concurrency(), uint32_t fiber_count = 128, size_t stack_size = 64 * 1024);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void run(Job const* jobs, size_t count, JobCounter* counter = nullptr);
+
+        void run(Job job, JobCounter* counter = nullptr) {
+            run(&job, 1, counter);
+        }
+
+        // Returns once counter drops to target or below.
+        void wait(JobCounter& counter, int target = 0);
+
+        // Called on the worker thread as each job completes.
+        std::function<void(JobTiming const&)> on_job_finished;
+
+        uint32_t worker_count;
+        size_t stack_size;
+
+    private:
+        struct Worker {
+            JobSystem* system;
+            uint32_t index;
+            void* scheduler; // ucontext_t of the worker thread
+            std::thread thread;
+        };
+
+        struct Pending {
+            Job job;
+            JobCounter* counter;
+        };
+
+        Fiber* create_fiber();
+        static void fiber_main();
+        void worker_main(Worker& worker);
+        void finish(JobCounter* counter);
+        void park(Fiber* fiber);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::mutex mutex; // guards everything below
+        ObjectPool<Fiber> fiber_pool;
+        std::vector<Fiber*> fibers; // every fiber made, freed with the system
+        std::condition_variable wake;
+        RingQueue<Pending> jobs;
+        RingQueue<Fiber*> ready;        // resumable after a wait
+        std::vector<Fiber*> free_fibers;
+        bool stopping = false;
+};
+
+// Aggregates JobTimings per job name, e.g. hooked to on_job_finished for a
+// headless run. Thread safe.
+class JobProfile {
+    public:
+        struct Entry {
+            uint64_t count = 0;
+            double total_ms = 0.0;
+            double max_ms = 0.0;
+        };
+
+        void record(JobTiming const& timing) {
+            double ms = std::chrono::duration<double, std::milli>(timing.end - timing.start).count();
+            std::lock_guard<std::mutex> lock (mutex);
+            Entry& entry = entries[timing.name];
+            entry.count++;
+            entry.total_ms += ms;
+            if (ms > entry.max_ms) entry.max_ms = ms;
+        }
+
+        void write_json(std::ostream& out) {
+            std::lock_guard<std::mutex> lock (mutex);
+            out << "{";
+            bool first = true;
+            for (auto const& [name, entry] : entries) {
+                out << (first ? "" : ",") << "\"" << name << "\":{\"count\":" << entry.count
+                    << ",\"total_ms\":" << entry.total_ms << ",\"max_ms\":" << entry.max_ms << "}";
+                first = false;
+            }
+            out << "}";
+        }
+
+        std::unordered_map<std::string, Entry> entries;
+
+    private:
+        std::mutex mutex;
+};
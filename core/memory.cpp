@@ -0,0 +1,145 @@
+#include "memory.hpp"
+#include <assert.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LinearAllocator::LinearAllocator(size_t capacity, std::pmr::memory_resource* upstream) {
+    this->capacity = capacity;
+    this->upstream = upstream;
+    buffer = static_cast<std::byte*>(upstream->allocate(capacity, alignof(std::max_align_t)));
+}
+
+LinearAllocator::~LinearAllocator() {
+    reset();
+    upstream->deallocate(buffer, capacity, alignof(std::max_align_t));
+}
+
+void LinearAllocator::reset() {
+    while (overflow) {
+        Overflow* next = overflow->next;
+        size_t header = align_up(sizeof(Overflow), overflow->alignment);
+        upstream->deallocate(overflow, header + overflow->bytes, overflow->alignment);
+        overflow = next;
+    }
+    offset = 0;
+}
+
+void* LinearAllocator::do_allocate(size_t bytes, size_t alignment) {
+    size_t start = align_up(offset, alignment);
+    if (start + bytes <= capacity) {
+        offset = start + bytes;
+        if (offset > high_water) high_water = offset;
+        return buffer + start;
+    }
+
+    // Out of frame memory: chain an upstream block so reset() can release it.
+    alignment = alignment < alignof(Overflow) ? alignof(Overflow) : alignment;
+    size_t header = align_up(sizeof(Overflow), alignment);
+    auto block = static_cast<std::byte*>(upstream->allocate(header + bytes, alignment));
+    overflow = new (block) Overflow { overflow, bytes, alignment };
+    overflow_count++;
+    return block + header;
+}
+
+void LinearAllocator::do_deallocate(void*, size_t, size_t) {
+}
+
+bool LinearAllocator::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+PoolResource::PoolResource(size_t block_size, size_t blocks_per_chunk, std::pmr::memory_resource* upstream) {
+    this->block_size = align_up(block_size < sizeof(Block) ? sizeof(Block) : block_size, alignof(std::max_align_t));
+    this->blocks_per_chunk = blocks_per_chunk;
+    this->upstream = upstream;
+}
+
+PoolResource::~PoolResource() {
+    size_t chunk_bytes = alignof(std::max_align_t) + block_size * blocks_per_chunk;
+    while (chunks) {
+        Chunk* next = chunks->next;
+        upstream->deallocate(chunks, chunk_bytes, alignof(std::max_align_t));
+        chunks = next;
+    }
+}
+
+void PoolResource::grow() {
+    // Chunk header sits in the first max_align_t slot, blocks follow.
+    size_t chunk_bytes = alignof(std::max_align_t) + block_size * blocks_per_chunk;
+    auto memory = static_cast<std::byte*>(upstream->allocate(chunk_bytes, alignof(std::max_align_t)));
+    chunks = new (memory) Chunk { chunks };
+    chunk_count++;
+
+    std::byte* first = memory + alignof(std::max_align_t);
+    for (size_t i = blocks_per_chunk; i-- > 0;) {
+        free_list = new (first + i * block_size) Block { free_list };
+    }
+}
+
+void* PoolResource::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes > block_size || alignment > alignof(std::max_align_t)) {
+        return upstream->allocate(bytes, alignment);
+    }
+
+    if (!free_list) grow();
+    Block* block = free_list;
+    free_list = block->next;
+    blocks_in_use++;
+    return block;
+}
+
+void PoolResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (bytes > block_size || alignment > alignof(std::max_align_t)) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    free_list = new (p) Block { free_list };
+    blocks_in_use--;
+}
+
+bool PoolResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+HugePageArena::HugePageArena(size_t capacity) {
+    this->capacity = align_up(capacity, HUGE_PAGE_SIZE);
+#ifdef __linux__
+    void* memory = mmap(nullptr, this->capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(memory != MAP_FAILED && "Could not map huge page arena.");
+    base = static_cast<std::byte*>(memory);
+#ifdef MADV_HUGEPAGE
+    huge_pages = madvise(base, this->capacity, MADV_HUGEPAGE) == 0;
+#endif
+#else
+    base = static_cast<std::byte*>(std::pmr::new_delete_resource()->allocate(this->capacity, alignof(std::max_align_t)));
+#endif
+}
+
+HugePageArena::~HugePageArena() {
+#ifdef __linux__
+    munmap(base, capacity);
+#else
+    std::pmr::new_delete_resource()->deallocate(base, capacity, alignof(std::max_align_t));
+#endif
+}
+
+void* HugePageArena::do_allocate(size_t bytes, size_t alignment) {
+    size_t start = align_up(offset, alignment);
+    assert(start + bytes <= capacity && "Huge page arena exhausted.");
+    offset = start + bytes;
+    return base + start;
+}
+
+void HugePageArena::do_deallocate(void*, size_t, size_t) {
+}
+
+bool HugePageArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bump allocator for data that dies at the end of a frame. deallocate is a
+// no-op; reset() rewinds everything at once. Requests past capacity fall back
+// to upstream and are counted in overflow_count so the capacity can be tuned.
+class LinearAllocator : public std::pmr::memory_resource {
+    public:
+        LinearAllocator(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        ~LinearAllocator();
+
+        LinearAllocator(const LinearAllocator&) = delete;
+        LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+        void reset();
+
+        size_t capacity;
+        size_t offset = 0;
+        size_t high_water = 0;
+        size_t overflow_count = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        struct Overflow {
+            Overflow* next;
+            size_t bytes;
+            size_t alignment;
+        };
+
+        std::pmr::memory_resource* upstream;
+        std::byte* buffer;
+        Overflow* overflow = nullptr;
+};
+
+// Fixed-size block pool for node-based containers. block_size is rounded up
+// to max_align_t. Anything larger (e.g. hash bucket arrays) is passed
+// straight to upstream. Not thread safe, same as the rest of the ECS.
+class PoolResource : public std::pmr::memory_resource {
+    public:
+        PoolResource(size_t block_size, size_t blocks_per_chunk = 256, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        ~PoolResource();
+
+        PoolResource(const PoolResource&) = delete;
+        PoolResource& operator=(const PoolResource&) = delete;
+
+        size_t block_size;
+        size_t blocks_per_chunk;
+        size_t blocks_in_use = 0;
+        size_t chunk_count = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        void grow();
+
+        struct Block { Block* next; };
+        struct Chunk { Chunk* next; };
+
+        std::pmr::memory_resource* upstream;
+        Block* free_list = nullptr;
+        Chunk* chunks = nullptr;
+};
+
+// Typed front end over PoolResource for objects the engine news/deletes often.
+template<typename T>
+class ObjectPool {
+    public:
+        ObjectPool(size_t objects_per_chunk = 256) : pool(sizeof(T), objects_per_chunk) {}
+
+        template<typename... Args>
+        T* create(Args&&... args) {
+            void* memory = pool.allocate(sizeof(T), alignof(T));
+            return new (memory) T(std::forward<Args>(args)...);
+        }
+
+        void destroy(T* object) {
+            object->~T();
+            pool.deallocate(object, sizeof(T), alignof(T));
+        }
+
+        PoolResource pool;
+};
+
+// Monotonic arena over one big anonymous mapping. On Linux the range is
+// madvise'd for transparent huge pages, which cuts TLB misses when walking
+// large component arrays. Memory is only returned when the arena dies.
+class HugePageArena : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+        HugePageArena(size_t capacity);
+        ~HugePageArena();
+
+        HugePageArena(const HugePageArena&) = delete;
+        HugePageArena& operator=(const HugePageArena&) = delete;
+
+        size_t capacity;
+        size_t offset = 0;
+        bool huge_pages = false; // madvise accepted
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        std::byte* base = nullptr;
+};
@@ -0,0 +1,115 @@
+#include "shared_ring.hpp"
+#include <cstring>
+#include <new>
+#include <assert.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char RING_MAGIC[4] = { 'E', 'C', 'S', 'R' };
+static const uint32_t RING_VERSION = 1;
+
+SharedRing::SharedRing(const char* name, size_t capacity) : name(name), owner(true) {
+    size_t rounded = 64;
+    while (rounded < capacity) rounded *= 2;
+#ifdef __linux__
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return;
+    size_t bytes = sizeof(Header) + rounded;
+    if (ftruncate(fd, bytes) == 0) map(fd, bytes);
+    close(fd);
+    if (!header) {
+        shm_unlink(name);
+        return;
+    }
+
+    new (header) Header();
+    memcpy(header->magic, RING_MAGIC, sizeof(RING_MAGIC));
+    header->version = RING_VERSION;
+    header->capacity = rounded;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_release);
+    this->capacity = rounded;
+#endif
+}
+
+SharedRing::SharedRing(const char* name) : name(name) {
+#ifdef __linux__
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) > sizeof(Header)) map(fd, info.st_size);
+    close(fd);
+    if (!header) return;
+
+    if (memcmp(header->magic, RING_MAGIC, sizeof(RING_MAGIC)) != 0 || header->version != RING_VERSION
+        || sizeof(Header) + header->capacity != mapped_bytes) {
+        munmap(header, mapped_bytes);
+        header = nullptr;
+        return;
+    }
+    capacity = header->capacity;
+#endif
+}
+
+SharedRing::~SharedRing() {
+#ifdef __linux__
+    if (header) munmap(header, mapped_bytes);
+    if (owner && header) shm_unlink(name.c_str());
+#endif
+}
+
+void SharedRing::map(int fd, size_t bytes) {
+#ifdef __linux__
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) return;
+    header = static_cast<Header*>(memory);
+    data = static_cast<uint8_t*>(memory) + sizeof(Header);
+    mapped_bytes = bytes;
+#endif
+}
+
+void SharedRing::copy_in(uint64_t position, void const* source, size_t size) {
+    size_t offset = position & (capacity - 1);
+    size_t first = size < capacity - offset ? size : capacity - offset;
+    memcpy(data + offset, source, first);
+    memcpy(data, static_cast<uint8_t const*>(source) + first, size - first);
+}
+
+void SharedRing::copy_out(uint64_t position, void* destination, size_t size) {
+    size_t offset = position & (capacity - 1);
+    size_t first = size < capacity - offset ? size : capacity - offset;
+    memcpy(destination, data + offset, first);
+    memcpy(static_cast<uint8_t*>(destination) + first, data, size - first);
+}
+
+bool SharedRing::push(void const* message, uint32_t size) {
+    assert(header && "Pushing to a ring that isn't open");
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    if (sizeof(size) + size > capacity - (head - tail)) return false;
+
+    copy_in(head, &size, sizeof(size));
+    if (size) copy_in(head + sizeof(size), message, size);
+    header->head.store(head + sizeof(size) + size, std::memory_order_release);
+    return true;
+}
+
+bool SharedRing::pop(std::vector<uint8_t>& message) {
+    assert(header && "Popping from a ring that isn't open");
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    if (tail == head) return false;
+
+    uint32_t size;
+    copy_out(tail, &size, sizeof(size));
+    message.resize(size);
+    if (size) copy_out(tail + sizeof(size), message.data(), size);
+    header->tail.store(tail + sizeof(size) + size, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Single-producer single-consumer queue of variable-length messages in a
+// POSIX shared memory object, for handing data between processes on one box
+// without locks. One side creates the object (and unlinks it on
+// destruction), the other opens it by name. Both must be the same build.
+class SharedRing {
+    public:
+        // Creates name with room for capacity bytes of messages, rounded up
+        // to a power of two. Replaces a stale object of the same name.
+        SharedRing(const char* name, size_t capacity);
+        // Opens a ring some other process created.
+        SharedRing(const char* name);
+        ~SharedRing();
+
+        SharedRing(const SharedRing&) = delete;
+        SharedRing& operator=(const SharedRing&) = delete;
+
+        bool is_open() const {
+            return header != nullptr;
+        }
+
+        // Producer side. Returns false, writing nothing, if the message
+        // doesn't fit right now.
+        bool push(void const* data, uint32_t size);
+
+        // Consumer side. Returns false if the ring is empty.
+        bool pop(std::vector<uint8_t>& message);
+
+        size_t capacity = 0;
+
+    private:
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint64_t capacity;
+            alignas(64) std::atomic<uint64_t> head; // bytes ever written
+            alignas(64) std::atomic<uint64_t> tail; // bytes ever read
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring positions must be lock free to live in shared memory");
+
+        void map(int fd, size_t bytes);
+        void copy_in(uint64_t position, void const* source, size_t size);
+        void copy_out(uint64_t position, void* destination, size_t size);
+
+        Header* header = nullptr;
+        uint8_t* data = nullptr;
+        size_t mapped_bytes = 0;
+        std::string name;
+        bool owner = false;
+};
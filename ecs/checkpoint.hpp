@@ -0,0 +1,196 @@
+#pragma once
+#include "ecs.hpp"
+#include "slot_extension.hpp"
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Copy-on-write history of a fixed-size slot array, one page at a time.
+// Writers mark the slots they touch; checkpoint() copies only the marked
+// pages and shares every other page with the previous checkpoint. Each
+// checkpoint remembers which page versions it replaced, so restoring walks
+// back over those entries and rewrites just the pages that differ.
+template<typename T>
+class PagedHistory {
+    public:
+        static constexpr size_t PAGE_BYTES = 4096;
+        static constexpr size_t PAGE_SLOTS = sizeof(T) >= PAGE_BYTES ? 1 : PAGE_BYTES / sizeof(T);
+        using Page = std::array<T, PAGE_SLOTS>;
+
+        PagedHistory(T* data, size_t slots) : data(data), slots(slots) {
+            size_t pages = (slots + PAGE_SLOTS - 1) / PAGE_SLOTS;
+            table.resize(pages);
+            flags.resize(pages, 0);
+            for (size_t page = 0; page < pages; page++) mark_page(page); // first checkpoint is the base copy
+        }
+
+        void mark(size_t slot) {
+            mark_page(slot / PAGE_SLOTS);
+        }
+
+        void mark_range(size_t begin, size_t end) {
+            if (begin >= end) return;
+            for (size_t page = begin / PAGE_SLOTS; page <= (end - 1) / PAGE_SLOTS; page++) mark_page(page);
+        }
+
+        void checkpoint() {
+            frames.emplace_back();
+            auto& frame = frames.back();
+            for (uint32_t page : dirty) {
+                auto copy = std::make_shared<Page>();
+                std::copy(data + first_slot(page), data + end_slot(page), copy->begin());
+                frame.push_back({ page, table[page] });
+                table[page] = copy;
+                flags[page] = 0;
+            }
+            dirty.clear();
+        }
+
+        void drop_oldest() {
+            frames.pop_front();
+        }
+
+        // Rewinds to `back` checkpoints before the latest one, which then
+        // becomes the latest.
+        void restore(size_t back) {
+            for (size_t i = 0; i < back; i++) {
+                for (auto const& change : frames.back()) {
+                    table[change.page] = change.before;
+                    mark_page(change.page);
+                }
+                frames.pop_back();
+            }
+            for (uint32_t page : dirty) {
+                std::copy(table[page]->begin(), table[page]->begin() + (end_slot(page) - first_slot(page)), data + first_slot(page));
+                flags[page] = 0;
+            }
+            dirty.clear();
+        }
+
+        size_t memory_usage() const {
+            size_t pages = 0;
+            for (auto const& frame : frames) pages += frame.size();
+            return pages * sizeof(Page) + table.size() * sizeof(table[0]);
+        }
+
+    private:
+        struct Change {
+            uint32_t page;
+            std::shared_ptr<Page> before;
+        };
+
+        void mark_page(size_t page) {
+            if (flags[page]) return;
+            flags[page] = 1;
+            dirty.push_back(static_cast<uint32_t>(page));
+        }
+
+        size_t first_slot(size_t page) const { return page * PAGE_SLOTS; }
+        size_t end_slot(size_t page) const { return std::min(slots, (page + 1) * PAGE_SLOTS); }
+
+        T* data;
+        size_t slots;
+        std::vector<std::shared_ptr<Page>> table; // page versions as of the latest checkpoint
+        std::deque<std::vector<Change>> frames;   // per checkpoint, pages it replaced
+        std::vector<uint8_t> flags;
+        std::vector<uint32_t> dirty;
+};
+
+// Checkpoint state of one ComponentArray: component pages, slot-to-entity
+// pages and the packed size. The entity-to-slot map is only rebuilt on
+// restore when slots were added, removed or reordered in between.
+template<typename T>
+struct ArrayHistory final : ISlotExtension<T> {
+    ArrayHistory(T* components, Entity* entities) : components(components, MAX_ENTITIES), entities(entities, MAX_ENTITIES) {}
+
+    void inserted(Entity, size_t slot, T&) override {
+        slot_moved(slot);
+    }
+
+    void departed(Entity, size_t, ComponentArray<T>&, size_t) override {
+        structure_dirty = true;
+    }
+
+    void moved(size_t from, size_t to) override {
+        slot_moved(from);
+        slot_moved(to);
+    }
+
+    void swapped(size_t a, size_t b) override {
+        slot_moved(a);
+        slot_moved(b);
+    }
+
+    void touched(size_t begin, size_t end) override {
+        components.mark_range(begin, end);
+    }
+
+    void slot_moved(size_t slot) {
+        components.mark(slot);
+        entities.mark(slot);
+        structure_dirty = true;
+    }
+
+    void checkpoint(size_t size) {
+        components.checkpoint();
+        entities.checkpoint();
+        sizes.push_back(size);
+        structural.push_back(structure_dirty);
+        structure_dirty = false;
+    }
+
+    void drop_oldest() {
+        components.drop_oldest();
+        entities.drop_oldest();
+        sizes.pop_front();
+        structural.pop_front();
+    }
+
+    // Returns the restored size; rebuild is set when slots moved.
+    size_t restore(size_t back, bool& rebuild) {
+        rebuild = structure_dirty;
+        for (size_t i = 0; i < back; i++) {
+            rebuild = rebuild || structural.back();
+            sizes.pop_back();
+            structural.pop_back();
+        }
+        components.restore(back);
+        entities.restore(back);
+        structure_dirty = false;
+        return sizes.back();
+    }
+
+    PagedHistory<T> components;
+    PagedHistory<Entity> entities;
+    std::deque<size_t> sizes;
+    std::deque<bool> structural;
+    bool structure_dirty = true;
+};
+
+// Checkpoint state of the EntityManager, kept like PagedHistory but per
+// entity: table holds each entity's free list link and signature as of the
+// latest checkpoint, and every checkpoint records the entries it replaced.
+// Only entities EntityManager reports as changed are copied or restored.
+struct EntityHistory {
+    struct Entry {
+        Entity next_free;
+        Signature signature;
+    };
+
+    struct Change {
+        Entity entity;
+        Entry before;
+    };
+
+    struct Frame {
+        uint64_t free_head;
+        uint32_t living_entity_count;
+        std::vector<Change> changes;
+        std::vector<size_t> group_sizes;
+    };
+
+    std::vector<Entry> table;
+    std::deque<Frame> frames;
+};
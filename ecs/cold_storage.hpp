@@ -0,0 +1,55 @@
+#pragma once
+#include "ecs.hpp"
+#include "slot_extension.hpp"
+#include <array>
+#include <assert.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Cold half of a component split into Hot and Cold. Slot i always belongs to
+// the entity in slot i of the owning ComponentArray<Hot>; the array forwards
+// every slot move so the two never drift apart. Values live in pages of
+// PAGE_SIZE allocated on first use, so the cold data costs nothing until
+// slots reach it and never shares cache lines with hot data.
+template<typename Hot, typename Cold>
+class ColdStorage final : public ISlotExtension<Hot> {
+    public:
+        static constexpr size_t PAGE_SIZE = 256;
+
+        Cold& at(size_t slot) {
+            return (*pages[slot / PAGE_SIZE])[slot % PAGE_SIZE];
+        }
+
+        void inserted(Entity, size_t slot, Hot&) override {
+            size_t page = slot / PAGE_SIZE;
+            while (pages.size() <= page) pages.push_back(std::make_unique<Page>());
+            at(slot) = Cold();
+        }
+
+        void departed(Entity, size_t slot, ComponentArray<Hot>& destination, size_t to) override {
+            auto other = destination.template extension<ColdStorage<Hot, Cold>>();
+            assert(other && "Destination didn't split this component");
+            other->at(to) = std::move(at(slot));
+        }
+
+        void moved(size_t from, size_t to) override {
+            if (from != to) at(to) = std::move(at(from));
+        }
+
+        void swapped(size_t a, size_t b) override {
+            std::swap(at(a), at(b));
+        }
+
+        bool bytes_are_value() const override {
+            return false; // the bytes are only the hot half
+        }
+
+        size_t memory_usage() override {
+            return pages.size() * sizeof(Page) + pages.capacity() * sizeof(void*);
+        }
+
+    private:
+        using Page = std::array<Cold, PAGE_SIZE>;
+        std::vector<std::unique_ptr<Page>> pages;
+};
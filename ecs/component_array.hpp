@@ -1,51 +1,306 @@
 #pragma once
 #include "ecs.hpp"
+#include "memory_report.hpp"
+#include "slot_extension.hpp"
+#include "checkpoint.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
 #include <unordered_map>
 #include <array>
 #include <assert.h>
+#include <utility>
+#include <cstring>
+#include <type_traits>
 
 class IComponentArray {
     public:
         virtual ~IComponentArray() = default;
         virtual void entity_destroyed(Entity entity) = 0;
+        virtual void remove(Entity entity) = 0; // entity known to be present
+
+        // Type-erased slot access for code that reorders storage without
+        // knowing T (sorting dependents, groups).
+        virtual size_t count() = 0;
+        virtual Entity entity_at(size_t index) = 0;
+        virtual bool contains(Entity entity) = 0;
+        virtual size_t index_of(Entity entity) = 0;
+        virtual void swap_entries(size_t a, size_t b) = 0;
+
+        virtual ComponentMemory memory_usage() = 0;
+
+        // Moves every slot whose entity has remap[entity] != NO_ENTITY onto
+        // the end of destination (same T) under its new id, and closes the
+        // gaps here keeping the remaining slots in order.
+        virtual void migrate_to(IComponentArray& destination, Entity const* remap) = 0;
+
+        // Raw byte access for the journal and shards, only for kinds whose
+        // bytes are their whole value.
+        virtual uint32_t component_size() = 0;
+        virtual bool serializable() { return false; }
+        virtual void insert_raw(Entity, void const*) {
+            assert(false && "Component kind can't be journaled");
+        }
+        virtual void const* raw_data(Entity) {
+            assert(false && "Component kind can't be journaled");
+            return nullptr;
+        }
+
+        // Rollback, see Coordinator::enable_checkpoints. Kinds that keep
+        // state outside the packed slots aren't covered and ignore these.
+        virtual void enable_checkpoints() {}
+        virtual void checkpoint() {}
+        virtual void drop_oldest_checkpoint() {}
+        virtual void restore_checkpoint(size_t) {}
 };
 
 template<typename T>
-class ComponentArray : public IComponentArray {
+class ComponentArray final : public IComponentArray {
     public:
+        // The index map draws its nodes from the owning world's pool and
+        // reserves buckets up front, so add/remove never rehash or hit malloc.
+        ComponentArray(std::pmr::memory_resource* nodes) : entity_to_index(nodes) {
+            entity_to_index.reserve(MAX_ENTITIES);
+        }
+
+        // Adds state that follows this array's slots (split, buffer and
+        // index kinds). Checkpoint history is dropped: a restore wouldn't
+        // roll the extension back with the slots.
+        void attach(std::shared_ptr<ISlotExtension<T>> extension) {
+            if (history) {
+                extensions.erase(std::find(extensions.begin(), extensions.end(), history));
+                history.reset();
+            }
+            extensions.push_back(extension);
+        }
+
+        template<typename Extension>
+        Extension* extension() {
+            for (auto const& attached : extensions) {
+                if (auto found = dynamic_cast<Extension*>(attached.get())) return found;
+            }
+            return nullptr;
+        }
+
+        bool watches_writes() const {
+            for (auto const& attached : extensions) {
+                if (attached->watches_writes()) return true;
+            }
+            return false;
+        }
+
         void insert_data(Entity entity, T component) {
             assert(entity_to_index.find(entity) == entity_to_index.end() && "Component added to same entity");
             size_t new_index = size;
             entity_to_index[entity] = new_index;
             index_to_entity[new_index] = entity;
-            component_array[new_index] = component;
+            component_array[new_index] = std::move(component);
+            size++;
+            for (auto const& attached : extensions) attached->inserted(entity, new_index, component_array[new_index]);
         }
 
         void remove_data(Entity entity) {
-            assert(entity_to_index.find(entity) == entity_to_index.end() && "Component added to same entity");
+            assert(entity_to_index.find(entity) != entity_to_index.end() && "Removing non-existent component");
             size_t index_of_removed_entity = entity_to_index[entity];
+            for (auto const& attached : extensions) attached->removed(entity, index_of_removed_entity, component_array[index_of_removed_entity]);
             size_t index_of_last_element = size - 1;
-            component_array[index_of_removed_entity] = component_array[index_of_last_element];
+            component_array[index_of_removed_entity] = std::move(component_array[index_of_last_element]);
+            for (auto const& attached : extensions) attached->moved(index_of_last_element, index_of_removed_entity);
 
             Entity entity_of_last_element = index_to_entity[index_of_last_element];
             entity_to_index[entity_of_last_element] = index_of_removed_entity;
             index_to_entity[index_of_removed_entity] = entity_of_last_element;
 
             entity_to_index.erase(entity);
-            index_to_entity.erase(index_of_last_element);
             size--;
         }
 
+        size_t count() override {
+            return size;
+        }
+
+        Entity entity_at(size_t index) override {
+            return index_to_entity[index];
+        }
+
+        bool contains(Entity entity) override {
+            return entity_to_index.find(entity) != entity_to_index.end();
+        }
+
+        size_t index_of(Entity entity) override {
+            return entity_to_index[entity];
+        }
+
+        // Exchanges two packed slots, keeping both index maps in step.
+        void swap_entries(size_t a, size_t b) override {
+            if (a == b) return;
+            std::swap(component_array[a], component_array[b]);
+            for (auto const& attached : extensions) attached->swapped(a, b);
+            Entity entity_a = index_to_entity[a];
+            Entity entity_b = index_to_entity[b];
+            index_to_entity[a] = entity_b;
+            index_to_entity[b] = entity_a;
+            entity_to_index[entity_a] = b;
+            entity_to_index[entity_b] = a;
+        }
+
         T& get_data(Entity entity) {
+            size_t index = entity_to_index[entity];
+            touch(index, index + 1);
+            return component_array[index];
+        }
+
+        // Read-only: doesn't mark the slot for the next checkpoint.
+        T const& read_data(Entity entity) {
             return component_array[entity_to_index[entity]];
         }
 
+        T const* try_read_data(Entity entity) {
+            auto it = entity_to_index.find(entity);
+            return it == entity_to_index.end() ? nullptr : &component_array[it->second];
+        }
+
+        // For code writing component_array directly (group iteration).
+        void touch(size_t begin, size_t end) {
+            for (auto const& attached : extensions) attached->touched(begin, end);
+        }
+
+        // Re-keys secondary indexes after the component was written in place.
+        void data_changed(Entity entity) {
+            if (extensions.empty()) return;
+            T const& component = get_data(entity);
+            for (auto const& attached : extensions) attached->changed(entity, component);
+        }
+
+        T* try_get_data(Entity entity) {
+            auto it = entity_to_index.find(entity);
+            if (it == entity_to_index.end()) return nullptr;
+            touch(it->second, it->second + 1);
+            return &component_array[it->second];
+        }
+
         void entity_destroyed(Entity entity) override {
             if (entity_to_index.find(entity) != entity_to_index.end()) remove_data(entity);
         }
 
+        void remove(Entity entity) override {
+            remove_data(entity);
+        }
+
+        void migrate_to(IComponentArray& destination, Entity const* remap) override {
+            auto& other = static_cast<ComponentArray<T>&>(destination);
+            size_t kept = 0;
+            for (size_t i = 0; i < size; i++) {
+                Entity entity = index_to_entity[i];
+                Entity moved = remap[entity];
+                if (moved != NO_ENTITY) {
+                    // The destination's extensions see an insert (a buffer
+                    // adopts its block there), the source's a departure
+                    // rather than a removal.
+                    size_t slot = other.size++;
+                    other.component_array[slot] = std::move(component_array[i]);
+                    other.index_to_entity[slot] = moved;
+                    other.entity_to_index[moved] = slot;
+                    for (auto const& attached : other.extensions) attached->inserted(moved, slot, other.component_array[slot]);
+                    for (auto const& attached : extensions) attached->departed(entity, i, other, slot);
+                    entity_to_index.erase(entity);
+                } else {
+                    if (kept != i) {
+                        component_array[kept] = std::move(component_array[i]);
+                        for (auto const& attached : extensions) attached->moved(i, kept);
+                        index_to_entity[kept] = entity;
+                        entity_to_index[entity] = kept;
+                    }
+                    kept++;
+                }
+            }
+            size = kept;
+        }
+
+        uint32_t component_size() override {
+            return sizeof(T);
+        }
+
+        bool serializable() override {
+            if (!std::is_trivially_copyable<T>::value) return false;
+            for (auto const& attached : extensions) {
+                if (!attached->bytes_are_value()) return false;
+            }
+            return true;
+        }
+
+        void insert_raw(Entity entity, void const* data) override {
+            assert(serializable() && "Component keeps state outside its bytes, can't be journaled or sent");
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                T component;
+                memcpy(&component, data, sizeof(T));
+                insert_data(entity, component);
+            } else {
+                assert(false && "Journaled components must be trivially copyable");
+            }
+        }
+
+        void const* raw_data(Entity entity) override {
+            assert(serializable() && "Component keeps state outside its bytes, can't be journaled or sent");
+            return &component_array[entity_to_index[entity]];
+        }
+
+        // Arrays with extensions and move-only components are skipped: a
+        // cold half, index entries or arena blocks wouldn't be rolled back
+        // with the slots, and pages can't be copied.
+        static constexpr bool CHECKPOINTABLE = std::is_copy_assignable<T>::value;
+
+        void enable_checkpoints() override {
+            if constexpr (CHECKPOINTABLE) {
+                if (!extensions.empty()) return;
+                history = std::make_shared<ArrayHistory<T>>(component_array.data(), index_to_entity.data());
+                extensions.push_back(history);
+            }
+        }
+
+        void checkpoint() override {
+            if constexpr (CHECKPOINTABLE) {
+                if (history) history->checkpoint(size);
+            }
+        }
+
+        void drop_oldest_checkpoint() override {
+            if constexpr (CHECKPOINTABLE) {
+                if (history) history->drop_oldest();
+            }
+        }
+
+        void restore_checkpoint(size_t back) override {
+            if constexpr (CHECKPOINTABLE) {
+                if (!history) return;
+                bool rebuild;
+                size = history->restore(back, rebuild);
+                if (!rebuild) return;
+                entity_to_index.clear();
+                for (size_t i = 0; i < size; i++) entity_to_index[index_to_entity[i]] = i;
+            }
+        }
+
+        ComponentMemory memory_usage() override {
+            ComponentMemory usage;
+            usage.component_size = sizeof(T);
+            usage.count = size;
+            usage.reserved_bytes = sizeof(component_array);
+            usage.live_bytes = sizeof(T) * size;
+            // Node-based map: bucket array plus one pooled node per entry.
+            size_t node_size = sizeof(void*) + sizeof(std::pair<const Entity, size_t>);
+            usage.index_bytes = sizeof(index_to_entity)
+                + entity_to_index.bucket_count() * sizeof(void*)
+                + entity_to_index.size() * pooled_node_bytes(node_size);
+            for (auto const& attached : extensions) usage.cold_bytes += attached->memory_usage();
+            usage.fragmentation = 1.0 - double(usage.live_bytes) / double(usage.reserved_bytes);
+            return usage;
+        }
+
         std::array<T, MAX_ENTITIES> component_array;
-        std::unordered_map<Entity, size_t> entity_to_index;
-        std::unordered_map<size_t, Entity> index_to_entity;
-        size_t size;
+        std::vector<std::shared_ptr<ISlotExtension<T>>> extensions;
+        std::shared_ptr<ArrayHistory<T>> history; // also in extensions while checkpoints are enabled
+        std::pmr::unordered_map<Entity, size_t> entity_to_index;
+        std::array<Entity, MAX_ENTITIES> index_to_entity;
+        size_t size = 0;
 };
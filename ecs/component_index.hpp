@@ -0,0 +1,112 @@
+#pragma once
+#include "ecs.hpp"
+#include "slot_extension.hpp"
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Receives every insert/remove/change of a T that goes through its
+// ComponentArray or the Coordinator.
+//
+// Contract: an index only sees writes made with set_component,
+// patch_component or reported with mark_changed. Writing in place through
+// component_array (views, groups, sorts) without mark_changed leaves it
+// stale; Coordinator::get_component/try_get_component assert in debug
+// builds once T has an index, so use read_component for reads.
+template<typename T>
+class IComponentIndex : public ISlotExtension<T> {
+    public:
+        virtual void insert(Entity entity, T const& component) = 0;
+        virtual void remove(Entity entity) = 0;
+        virtual void update(Entity entity, T const& component) = 0;
+
+        void inserted(Entity entity, size_t, T& component) override {
+            insert(entity, component);
+        }
+
+        void removed(Entity entity, size_t, T&) override {
+            remove(entity);
+        }
+
+        void departed(Entity entity, size_t, ComponentArray<T>&, size_t) override {
+            remove(entity);
+        }
+
+        void changed(Entity entity, T const& component) override {
+            update(entity, component);
+        }
+
+        bool watches_writes() const override {
+            return true;
+        }
+};
+
+// Secondary index from key(component) to the entities holding that key.
+// Lookups are O(result); an update only moves the entity when its key
+// actually changed. Map is a hash map (HashIndex) or an ordered map
+// (SortedIndex, which adds range queries).
+template<typename T, typename Key, typename Map>
+class ComponentIndex : public IComponentIndex<T> {
+    public:
+        ComponentIndex(std::function<Key(T const&)> key) : key(key), key_of(MAX_ENTITIES), slot_of(MAX_ENTITIES) {}
+
+        void insert(Entity entity, T const& component) override {
+            link(entity, key(component));
+        }
+
+        void remove(Entity entity) override {
+            unlink(entity);
+        }
+
+        void update(Entity entity, T const& component) override {
+            Key new_key = key(component);
+            if (new_key == key_of[entity]) return;
+            unlink(entity);
+            link(entity, new_key);
+        }
+
+        std::vector<Entity> const& find(Key const& value) const {
+            static const std::vector<Entity> none;
+            auto it = buckets.find(value);
+            return it == buckets.end() ? none : it->second;
+        }
+
+        // f(Entity) for every entity with low <= key <= high. SortedIndex only.
+        template<typename F>
+        void for_range(Key const& low, Key const& high, F&& f) const {
+            for (auto it = buckets.lower_bound(low); it != buckets.end() && !(high < it->first); ++it) {
+                for (Entity entity : it->second) f(entity);
+            }
+        }
+
+        std::function<Key(T const&)> key;
+        Map buckets;
+
+    private:
+        void link(Entity entity, Key const& value) {
+            auto& entities = buckets[value];
+            key_of[entity] = value;
+            slot_of[entity] = static_cast<uint32_t>(entities.size());
+            entities.push_back(entity);
+        }
+
+        void unlink(Entity entity) {
+            auto it = buckets.find(key_of[entity]);
+            auto& entities = it->second;
+            Entity last = entities.back();
+            entities[slot_of[entity]] = last;
+            slot_of[last] = slot_of[entity];
+            entities.pop_back();
+            if (entities.empty()) buckets.erase(it);
+        }
+
+        std::vector<Key> key_of;
+        std::vector<uint32_t> slot_of;
+};
+
+template<typename T, typename Key>
+using HashIndex = ComponentIndex<T, Key, std::unordered_map<Key, std::vector<Entity>>>;
+
+template<typename T, typename Key>
+using SortedIndex = ComponentIndex<T, Key, std::map<Key, std::vector<Entity>>>;
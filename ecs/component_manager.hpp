@@ -1,19 +1,34 @@
 #pragma once
 #include "ecs.hpp"
 #include "component_array.hpp"
+#include "shared_component.hpp"
 #include <unordered_map>
 #include <assert.h>
 #include <memory>
+#include <array>
 
 class ComponentManager {
     public:
+        // nodes backs the arrays' index maps; it must outlive this manager.
+        ComponentManager(std::pmr::memory_resource* nodes) : nodes(nodes) {}
+
+        // storage lets big arrays live in a caller-owned arena (e.g. a
+        // HugePageArena); it must outlive this manager.
         template<typename T>
-        void register_component() {
-            const char* type_name = typeid(T).name();
-            assert(component_types.find(type_name) == component_types.end() && "Component types registered more than once.");
-            component_types.insert({ type_name, next_component_type });
-            component_arrays.insert({ type_name, std::make_shared<ComponentArray<T>>()});
-            next_component_type++;
+        void register_component(std::pmr::memory_resource* storage = nullptr) {
+            std::shared_ptr<IComponentArray> array;
+            if (storage) {
+                array = std::allocate_shared<ComponentArray<T>>(std::pmr::polymorphic_allocator<ComponentArray<T>>(storage), nodes);
+            } else {
+                array = std::make_shared<ComponentArray<T>>(nodes);
+            }
+            add_array(typeid(T).name(), array);
+        }
+
+        // Registered under Shared<T>, which is also the type to filter on.
+        template<typename T, typename Hash = std::hash<T>>
+        void register_shared_component() {
+            add_array(typeid(Shared<T>).name(), std::make_shared<SharedComponentArray<T, Hash>>());
         }
 
         template<typename T>
@@ -25,7 +40,7 @@ class ComponentManager {
 
         template<typename T>
         void add_component(Entity entity, T component) {
-            get_component_array<T>()->insert_data(entity, component);
+            get_component_array<T>()->insert_data(entity, std::move(component));
         }
 
         template<typename T>
@@ -35,13 +50,51 @@ class ComponentManager {
 
         template<typename T>
         T& get_component(Entity entity) {
-            return get_component_array<T>->get_data(entity);
+            return get_component_array<T>()->get_data(entity);
         }
 
-        void entity_destroyed(Entity entity) {
-            for (auto const& pair : component_arrays) {
-                auto const& component = pair.second;
-                component->entity_destroyed(entity);
+        template<typename T>
+        T* try_get_component(Entity entity) {
+            return get_component_array<T>()->try_get_data(entity);
+        }
+
+        template<typename T>
+        T const& read_component(Entity entity) {
+            return get_component_array<T>()->read_data(entity);
+        }
+
+        template<typename T>
+        T const* try_read_component(Entity entity) {
+            return get_component_array<T>()->try_read_data(entity);
+        }
+
+        // The signature says exactly which arrays hold the entity; nothing
+        // else is visited.
+        void entity_destroyed(Entity entity, Signature signature) {
+            for (ComponentType type = 0; type < next_component_type; type++) {
+                if (signature.test(type)) arrays_by_type[type]->remove(entity);
+            }
+        }
+
+        // Array-major so each array's storage stays hot across the batch.
+        void entities_destroyed(Entity const* entities, Signature const* signatures, size_t count) {
+            Signature touched;
+            for (size_t e = 0; e < count; e++) touched |= signatures[e];
+
+            for (ComponentType type = 0; type < next_component_type; type++) {
+                if (!touched.test(type)) continue;
+                IComponentArray* array = arrays_by_type[type];
+                for (size_t e = 0; e < count; e++) {
+                    if (signatures[e].test(type)) array->remove(entities[e]);
+                }
+            }
+        }
+
+        void memory_report(MemoryReport& report) {
+            for (ComponentType type = 0; type < next_component_type; type++) {
+                ComponentMemory usage = arrays_by_type[type]->memory_usage();
+                usage.name = readable_type_name(type_names[type]);
+                report.components.push_back(usage);
             }
         }
 
@@ -51,7 +104,26 @@ class ComponentManager {
             return std::static_pointer_cast<ComponentArray<T>>(component_arrays[type_name]);
         }
 
+        template<typename T, typename Hash = std::hash<T>>
+        std::shared_ptr<SharedComponentArray<T, Hash>> get_shared_array() {
+            const char* type_name = typeid(Shared<T>).name();
+            return std::static_pointer_cast<SharedComponentArray<T, Hash>>(component_arrays[type_name]);
+        }
+
+        void add_array(const char* type_name, std::shared_ptr<IComponentArray> array) {
+            assert(component_types.find(type_name) == component_types.end() && "Component types registered more than once.");
+            assert(next_component_type < MAX_COMPONENTS && "Too many component types.");
+            component_types.insert({ type_name, next_component_type });
+            component_arrays.insert({ type_name, array });
+            arrays_by_type[next_component_type] = array.get();
+            type_names[next_component_type] = type_name;
+            next_component_type++;
+        }
+
         std::unordered_map<const char*, ComponentType> component_types;
         std::unordered_map<const char*, std::shared_ptr<IComponentArray>> component_arrays;
-        ComponentType next_component_type;
+        std::array<IComponentArray*, MAX_COMPONENTS> arrays_by_type {};
+        std::array<const char*, MAX_COMPONENTS> type_names {};
+        ComponentType next_component_type = 0;
+        std::pmr::memory_resource* nodes;
 };
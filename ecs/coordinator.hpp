@@ -3,53 +3,474 @@
 #include "system_manager.hpp"
 #include "entity_manager.hpp"
 #include "component_manager.hpp"
+#include "relation_manager.hpp"
+#include "group.hpp"
+#include "sort.hpp"
+#include "dynamic_buffer.hpp"
+#include "cold_storage.hpp"
+#include "component_index.hpp"
+#include "query_cache.hpp"
+#include "journal.hpp"
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 class Coordinator {
     public:
         inline void init() {
-            component_manager = std::make_unique<ComponentManager>();
+            component_manager = std::make_unique<ComponentManager>(&node_pool);
             entity_manager = std::make_unique<EntityManager>();
-            system_manager = std::make_unique<SystemManager>();
+            system_manager = std::make_unique<SystemManager>(&node_pool);
+            resource_manager = std::make_unique<ResourceManager>();
+            relation_manager = std::make_unique<RelationManager>();
+            query_cache = std::make_unique<QueryCache>();
         }
 
         inline void destroy_entity(Entity entity) {
+            if (relation_manager->has_cascade(entity)) {
+                destroy_entities(&entity, 1);
+                return;
+            }
+
+            if (journal) journal->destroy_entity(entity);
+            relation_manager->entity_destroyed(entity);
+            Signature signature = entity_manager->get_signature(entity);
+            groups_signature_changed(entity, signature, Signature());
+            component_manager->entity_destroyed(entity, signature);
+            system_manager->entity_destroyed(entity, signature);
+            query_cache->entity_destroyed(entity, signature);
             entity_manager->destroy_entity(entity);
-            component_manager->entity_destroyed(entity);
-            system_manager->entity_destroyed(entity);
+        }
+
+        // Mass despawn: each component array and system is visited once for
+        // the whole batch, and only if some entity in it has a matching bit.
+        // Sources of cascading relations (children) are pulled into the batch.
+        inline void destroy_entities(Entity const* entities, size_t count) {
+            std::vector<Entity> cascade;
+            if (relation_manager->any_cascade) {
+                relation_manager->collect_cascade(entities, count, cascade);
+                entities = cascade.data();
+                count = cascade.size();
+            }
+
+            for (size_t i = 0; i < count; i++) relation_manager->entity_destroyed(entities[i]);
+            if (journal) {
+                for (size_t i = 0; i < count; i++) journal->destroy_entity(entities[i]);
+            }
+
+            std::vector<Signature> signatures (count);
+            for (size_t i = 0; i < count; i++) {
+                signatures[i] = entity_manager->get_signature(entities[i]);
+                groups_signature_changed(entities[i], signatures[i], Signature());
+            }
+
+            component_manager->entities_destroyed(entities, signatures.data(), count);
+            system_manager->entities_destroyed(entities, signatures.data(), count);
+            query_cache->entities_destroyed(entities, signatures.data(), count);
+            for (size_t i = 0; i < count; i++) entity_manager->destroy_entity(entities[i]);
+        }
+
+        inline void destroy_entities(std::vector<Entity> const& entities) {
+            destroy_entities(entities.data(), entities.size());
         }
 
         inline Entity create_entity() {
-            return entity_manager->create_entity();
+            Entity entity = entity_manager->create_entity();
+            if (journal) journal->create_entity(entity);
+            return entity;
+        }
+
+        // Moves entities, with all their components, out of source into this
+        // world: one packed append per component type plus a single id remap,
+        // instead of re-spawning them one by one. Component types are matched
+        // by type, so registration order may differ between the worlds, but
+        // every type the entities carry must be registered here. Neither world
+        // may be in use by another thread while this runs. Returns the new ids,
+        // parallel to entities.
+        inline std::vector<Entity> migrate_entities(Coordinator& source, Entity const* entities, size_t count) {
+            std::vector<Entity> moved (count);
+            entity_manager->create_entities(moved.data(), count);
+
+            std::vector<Entity> remap (MAX_ENTITIES, NO_ENTITY);
+            std::vector<Signature> signatures (count);
+            Signature touched;
+            for (size_t i = 0; i < count; i++) {
+                remap[entities[i]] = moved[i];
+                signatures[i] = source.entity_manager->get_signature(entities[i]);
+                touched |= signatures[i];
+                source.groups_signature_changed(entities[i], signatures[i], Signature());
+                source.relation_manager->entity_destroyed(entities[i]); // pairs don't cross worlds
+            }
+
+            std::array<ComponentType, MAX_COMPONENTS> type_map;
+            bool same_types = true;
+            for (ComponentType type = 0; type < source.component_manager->next_component_type; type++) {
+                if (!touched.test(type)) continue;
+                auto it = component_manager->component_types.find(source.component_manager->type_names[type]);
+                assert(it != component_manager->component_types.end() && "Migrating a component type the destination never registered");
+                type_map[type] = it->second;
+                same_types = same_types && it->second == type;
+                source.component_manager->arrays_by_type[type]->migrate_to(*component_manager->arrays_by_type[it->second], remap.data());
+            }
+
+            if (source.journal) {
+                for (size_t i = 0; i < count; i++) source.journal->destroy_entity(entities[i]);
+            }
+            source.system_manager->entities_destroyed(entities, signatures.data(), count);
+            source.query_cache->entities_destroyed(entities, signatures.data(), count);
+            source.entity_manager->destroy_entities(entities, count);
+
+            for (size_t i = 0; i < count; i++) {
+                Signature signature = signatures[i];
+                if (!same_types) {
+                    signature.reset();
+                    for (ComponentType type = 0; type < source.component_manager->next_component_type; type++) {
+                        if (signatures[i].test(type)) signature.set(type_map[type]);
+                    }
+                }
+                entity_manager->set_signature(moved[i], signature);
+                groups_signature_changed(moved[i], Signature(), signature);
+                system_manager->entity_signature_changed(moved[i], Signature(), signature);
+                query_cache->entity_signature_changed(moved[i], Signature(), signature);
+                if (journal) {
+                    journal->create_entity(moved[i]);
+                    for (ComponentType type = 0; type < component_manager->next_component_type; type++) {
+                        if (signature.test(type)) journal_add(moved[i], type, nullptr);
+                    }
+                }
+            }
+
+            return moved;
+        }
+
+        inline std::vector<Entity> migrate_entities(Coordinator& source, std::vector<Entity> const& entities) {
+            return migrate_entities(source, entities.data(), entities.size());
+        }
+
+        // Moves every live entity of source, with or without components, e.g.
+        // a level section built on a loading thread into the live world.
+        // Source must be quiescent (see EntityManager::living_entities).
+        inline std::vector<Entity> merge(Coordinator& source) {
+            return migrate_entities(source, source.entity_manager->living_entities());
+        }
+
+        // exclusive: a source has at most one target, adding replaces (ChildOf).
+        // cascade: destroying a target destroys every source, recursively.
+        template<typename R>
+        inline void register_relation(bool exclusive = false, bool cascade = false) {
+            relation_manager->register_relation<R>(exclusive, cascade);
+        }
+
+        template<typename R>
+        inline void add_relation(Entity source, Entity target) {
+            if (journal) journal->fail("relations aren't journaled");
+            relation_manager->get_relation<R>().add(source, target);
+        }
+
+        template<typename R>
+        inline void remove_relation(Entity source, Entity target) {
+            if (journal) journal->fail("relations aren't journaled");
+            relation_manager->get_relation<R>().remove(source, target);
+        }
+
+        template<typename R>
+        inline bool has_relation(Entity source, Entity target) {
+            return relation_manager->get_relation<R>().has(source, target);
+        }
+
+        // Every entity with R(target), e.g. related<ChildOf>(parent) for children.
+        template<typename R>
+        inline std::vector<Entity> const& related(Entity target) {
+            return relation_manager->get_relation<R>().sources_of[target];
+        }
+
+        template<typename R>
+        inline std::vector<Entity> const& relation_targets(Entity source) {
+            return relation_manager->get_relation<R>().targets_of[source];
         }
 
         template<typename T> 
-        inline void register_component() {
-            component_manager->register_component<T>();
+        inline void register_component(std::pmr::memory_resource* storage = nullptr) {
+            component_manager->register_component<T>(storage);
+            if (!max_checkpoints) return;
+            // Registered mid-history: the array was empty at every checkpoint
+            // still retained, so record that many to line up with the rest.
+            auto array = component_manager->get_component_array<T>();
+            array->enable_checkpoints();
+            for (size_t i = 0; i < entity_history.frames.size(); i++) array->checkpoint();
+        }
+
+        // Splits a component into Hot, packed for iteration, and Cold, kept
+        // in a separate paged pool at the same dense index. Hot loops only
+        // ever walk Hot; add_component(entity, hot) default-initializes Cold.
+        template<typename Hot, typename Cold>
+        inline void register_split_component(std::pmr::memory_resource* storage = nullptr) {
+            component_manager->register_component<Hot>(storage);
+            component_manager->get_component_array<Hot>()->attach(std::make_shared<ColdStorage<Hot, Cold>>());
+        }
+
+        template<typename Hot, typename Cold>
+        inline void add_component(Entity entity, Hot hot, Cold cold) {
+            add_component(entity, hot);
+            get_cold_component<Hot, Cold>(entity) = std::move(cold);
+        }
+
+        template<typename Hot, typename Cold>
+        inline Cold& get_cold_component(Entity entity) {
+            auto array = component_manager->get_component_array<Hot>();
+            auto cold = array->template extension<ColdStorage<Hot, Cold>>();
+            assert(cold && "Component not split with this cold type");
+            return cold->at(array->index_of(entity));
+        }
+
+        // Registers a DynamicBuffer<T, N> component and the world's
+        // BufferArena<T> (shared by every buffer of T) as a resource.
+        template<typename Buffer>
+        inline void register_buffer(std::pmr::memory_resource* storage = nullptr) {
+            using Arena = BufferArena<typename Buffer::value_type>;
+            component_manager->register_component<Buffer>(storage);
+            Arena* arena = resource_manager->get<Arena>();
+            if (!arena) arena = &resource_manager->insert<Arena>(Arena());
+            component_manager->get_component_array<Buffer>()->attach(std::make_shared<BufferSlots<Buffer>>(*arena));
+        }
+
+        template<typename T>
+        inline BufferArena<T>& buffer_arena() {
+            return get_resource<BufferArena<T>>();
         }
 
         template<typename T>
         inline void add_component(Entity entity, T component) {
-            component_manager->add_component<T>(entity, component);
-            auto signature = entity_manager->get_signature(entity);
+            if (journal) journal_add(entity, component_manager->get_component_type<T>(), &component);
+            component_manager->add_component<T>(entity, std::move(component));
+            auto old_signature = entity_manager->get_signature(entity);
+            auto signature = old_signature;
             signature.set(component_manager->get_component_type<T>(), true);
             entity_manager->set_signature(entity, signature);
-            system_manager->entity_signature_changed(entity, signature);
+            groups_signature_changed(entity, old_signature, signature);
+            system_manager->entity_signature_changed(entity, old_signature, signature);
+            query_cache->entity_signature_changed(entity, old_signature, signature);
         }
 
         template<typename T>
         inline void remove_component(Entity entity) {
-            component_manager->remove_component<T>(entity);
-            auto signature = entity_manager->get_signature(entity);
+            if (journal) journal->remove_component(entity, component_manager->get_component_type<T>());
+            auto old_signature = entity_manager->get_signature(entity);
+            auto signature = old_signature;
             signature.set(component_manager->get_component_type<T>(), false);
+            groups_signature_changed(entity, old_signature, signature);
+            component_manager->remove_component<T>(entity);
+            entity_manager->set_signature(entity, signature);
+            system_manager->entity_signature_changed(entity, old_signature, signature);
+            query_cache->entity_signature_changed(entity, old_signature, signature);
+        }
+
+        // Shared components: entities with equal values reference one stored
+        // copy. Hash defaults to std::hash<T>, so pointers (Mesh*, Material*)
+        // work out of the box.
+        template<typename T, typename Hash = std::hash<T>>
+        inline void register_shared_component() {
+            component_manager->register_shared_component<T, Hash>();
+        }
+
+        template<typename T, typename Hash = std::hash<T>>
+        inline void add_shared_component(Entity entity, T value) {
+            if (journal) journal->fail("shared components aren't journaled");
+            component_manager->get_shared_array<T, Hash>()->insert_data(entity, value);
+            auto old_signature = entity_manager->get_signature(entity);
+            auto signature = old_signature;
+            signature.set(component_manager->get_component_type<Shared<T>>(), true);
+            entity_manager->set_signature(entity, signature);
+            groups_signature_changed(entity, old_signature, signature);
+            system_manager->entity_signature_changed(entity, old_signature, signature);
+            query_cache->entity_signature_changed(entity, old_signature, signature);
+        }
+
+        template<typename T, typename Hash = std::hash<T>>
+        inline void remove_shared_component(Entity entity) {
+            if (journal) journal->fail("shared components aren't journaled");
+            auto old_signature = entity_manager->get_signature(entity);
+            auto signature = old_signature;
+            signature.set(component_manager->get_component_type<Shared<T>>(), false);
+            groups_signature_changed(entity, old_signature, signature);
+            component_manager->get_shared_array<T, Hash>()->remove_data(entity);
+            entity_manager->set_signature(entity, signature);
+            system_manager->entity_signature_changed(entity, old_signature, signature);
+            query_cache->entity_signature_changed(entity, old_signature, signature);
+        }
+
+        template<typename T, typename Hash = std::hash<T>>
+        inline void set_shared_component(Entity entity, T value) {
+            if (journal) journal->fail("shared components aren't journaled");
+            component_manager->get_shared_array<T, Hash>()->set_data(entity, value);
+        }
+
+        template<typename T, typename Hash = std::hash<T>>
+        inline T const& get_shared_component(Entity entity) {
+            return component_manager->get_shared_array<T, Hash>()->get_data(entity);
+        }
+
+        // f(T const& value, std::vector<Entity> const& entities) per distinct value.
+        template<typename T, typename Hash = std::hash<T>, typename F>
+        inline void for_each_group(F&& f) {
+            component_manager->get_shared_array<T, Hash>()->for_each_group(f);
+        }
+
+        // Type-erased add/remove from raw bytes, used by replay.
+        inline void add_component_raw(Entity entity, ComponentType type, void const* data) {
+            if (journal) journal_add(entity, type, data);
+            component_manager->arrays_by_type[type]->insert_raw(entity, data);
+            auto old_signature = entity_manager->get_signature(entity);
+            auto signature = old_signature;
+            signature.set(type, true);
+            entity_manager->set_signature(entity, signature);
+            groups_signature_changed(entity, old_signature, signature);
+            system_manager->entity_signature_changed(entity, old_signature, signature);
+            query_cache->entity_signature_changed(entity, old_signature, signature);
+        }
+
+        inline void remove_component_raw(Entity entity, ComponentType type) {
+            if (journal) journal->remove_component(entity, type);
+            auto old_signature = entity_manager->get_signature(entity);
+            auto signature = old_signature;
+            signature.set(type, false);
+            groups_signature_changed(entity, old_signature, signature);
+            component_manager->arrays_by_type[type]->remove(entity);
             entity_manager->set_signature(entity, signature);
-            system_manager->entity_signature_changed(entity, signature);
+            system_manager->entity_signature_changed(entity, old_signature, signature);
+            query_cache->entity_signature_changed(entity, old_signature, signature);
         }
 
+        // Re-drives a recorded session into this world, which must have the
+        // same component types registered (matched by name) and should start
+        // empty. Recorded ids are remapped to fresh ones. on_tick(dt) runs the
+        // systems once each tick's changes are in. Returns the number of
+        // ticks replayed. Replay stops at the first record that doesn't fit
+        // the world so far (unknown entity or component type, component added
+        // twice, ...) and flags reader.corrupt.
+        template<typename OnTick>
+        inline uint64_t replay(JournalReader& reader, OnTick&& on_tick) {
+            std::vector<Entity> remap (MAX_ENTITIES, NO_ENTITY);
+            std::array<ComponentType, MAX_COMPONENTS> type_map {};
+            JournalRecord record;
+            uint64_t ticks = 0;
+
+            while (reader.next(record)) {
+                switch (record.op) {
+                    case JournalOp::TYPE: {
+                        std::string name (reinterpret_cast<const char*>(record.data), record.name_length);
+                        bool found = false;
+                        for (ComponentType type = 0; type < component_manager->next_component_type; type++) {
+                            if (name == component_manager->type_names[type]) {
+                                if (component_manager->arrays_by_type[type]->component_size() != record.size) return rejected(reader, ticks);
+                                type_map[record.type] = type;
+                                found = true;
+                            }
+                        }
+                        if (!found) return rejected(reader, ticks);
+                        break;
+                    }
+                    case JournalOp::CREATE:
+                        if (remap[record.entity] != NO_ENTITY) return rejected(reader, ticks);
+                        remap[record.entity] = create_entity();
+                        break;
+                    case JournalOp::DESTROY:
+                        if (remap[record.entity] == NO_ENTITY) return rejected(reader, ticks);
+                        destroy_entity(remap[record.entity]);
+                        remap[record.entity] = NO_ENTITY;
+                        break;
+                    case JournalOp::ADD:
+                        if (remap[record.entity] == NO_ENTITY || entity_manager->get_signature(remap[record.entity]).test(type_map[record.type])) return rejected(reader, ticks);
+                        add_component_raw(remap[record.entity], type_map[record.type], record.data);
+                        break;
+                    case JournalOp::REMOVE:
+                        if (remap[record.entity] == NO_ENTITY || !entity_manager->get_signature(remap[record.entity]).test(type_map[record.type])) return rejected(reader, ticks);
+                        remove_component_raw(remap[record.entity], type_map[record.type]);
+                        break;
+                    case JournalOp::TICK:
+                        on_tick(record.dt);
+                        ticks++;
+                        break;
+                }
+            }
+            return ticks;
+        }
+
+        // Mutable access. An index can't see writes through the returned
+        // reference, so indexed components refuse it in debug builds: read
+        // them with read_component and write with set_component or
+        // patch_component.
         template<typename T>
         inline T& get_component(Entity entity) {
+            assert(!component_manager->get_component_array<T>()->watches_writes() && "Indexed component: use read_component/set_component/patch_component");
             return component_manager->get_component<T>(entity);
         }
 
+        template<typename T>
+        inline T const& read_component(Entity entity) {
+            return component_manager->read_component<T>(entity);
+        }
+
+        // Writes that secondary indexes on T should see must go through
+        // set_component/patch_component, or be reported with mark_changed.
+        template<typename T>
+        inline void set_component(Entity entity, T component) {
+            auto array = component_manager->get_component_array<T>();
+            array->get_data(entity) = std::move(component);
+            array->data_changed(entity);
+        }
+
+        template<typename T, typename F>
+        inline void patch_component(Entity entity, F&& f) {
+            auto array = component_manager->get_component_array<T>();
+            f(array->get_data(entity));
+            array->data_changed(entity);
+        }
+
+        template<typename T>
+        inline void mark_changed(Entity entity) {
+            component_manager->get_component_array<T>()->data_changed(entity);
+        }
+
+        // e.g. auto by_team = register_index<Team>([](Team const& t) { return t.id; });
+        //      for (Entity e : by_team->find(3)) ...
+        template<typename T, typename KeyFunction>
+        inline auto register_index(KeyFunction key) {
+            using Key = std::decay_t<decltype(key(std::declval<T const&>()))>;
+            return add_index<T>(std::make_shared<HashIndex<T, Key>>(key));
+        }
+
+        // Ordered variant with for_range(low, high, f).
+        template<typename T, typename KeyFunction>
+        inline auto register_sorted_index(KeyFunction key) {
+            using Key = std::decay_t<decltype(key(std::declval<T const&>()))>;
+            return add_index<T>(std::make_shared<SortedIndex<T, Key>>(key));
+        }
+
+        template<typename T, typename Index>
+        inline std::shared_ptr<Index> add_index(std::shared_ptr<Index> index) {
+            auto array = component_manager->get_component_array<T>();
+            for (size_t i = 0; i < array->size; i++) {
+                index->insert(array->index_to_entity[i], array->component_array[i]);
+            }
+            array->attach(index); // drops checkpoint history
+            return index;
+        }
+
+        // nullptr when the entity doesn't have T, for Optional<T> reads.
+        // Same rule as get_component for indexed components.
+        template<typename T>
+        inline T* try_get_component(Entity entity) {
+            assert(!component_manager->get_component_array<T>()->watches_writes() && "Indexed component: use try_read_component/set_component/patch_component");
+            return component_manager->try_get_component<T>(entity);
+        }
+
+        template<typename T>
+        inline T const* try_read_component(Entity entity) {
+            return component_manager->try_read_component<T>(entity);
+        }
+
         template<typename T>
         inline ComponentType get_component_type() {
             return component_manager->get_component_type<T>();
@@ -62,10 +483,288 @@ class Coordinator {
 
         template<typename T>
         inline void set_system_signature(Signature signature) {
-            system_manager->set_signature<T>(signature);
+            system_manager->set_signature<T>(signature, entity_manager->signatures.data());
+        }
+
+        // e.g. set_system_filter<PhysicsSystem>(With<Transform, Velocity>(), Without<Static>());
+        template<typename T, typename... Filters>
+        inline void set_system_filter(Filters... filters) {
+            SystemFilter filter;
+            (add_to_filter(filter, filters), ...);
+            system_manager->set_filter<T>(filter, entity_manager->signatures.data());
+        }
+
+        // e.g. for (Entity e : query(With<Transform, Health>(), Without<Dead>())) ...
+        // The result is cached and kept current; the reference stays valid
+        // until release_query.
+        template<typename... Filters>
+        inline std::vector<Entity> const& query(Filters... filters) {
+            SystemFilter filter;
+            (add_to_filter(filter, filters), ...);
+            return query(filter.include, filter.exclude);
+        }
+
+        inline std::vector<Entity> const& query(Signature include, Signature exclude = Signature()) {
+            return query_cache->get(include, exclude, entity_manager->signatures.data()).entities;
+        }
+
+        inline void release_query(Signature include, Signature exclude = Signature()) {
+            query_cache->release(include, exclude);
+        }
+
+        template<typename T>
+        inline T& insert_resource(T resource) {
+            return resource_manager->insert<T>(resource);
+        }
+
+        template<typename T>
+        inline void remove_resource() {
+            resource_manager->remove<T>();
+        }
+
+        template<typename T>
+        inline T& get_resource() {
+            T* resource = resource_manager->get<T>();
+            assert(resource && "Resource not inserted");
+            return *resource;
+        }
+
+        // e.g. declare_resource_access<CameraSystem>(Read<Input>(), Write<Camera>());
+        template<typename T, typename... Access>
+        inline void declare_resource_access(Access... access) {
+            ResourceAccess resource_access;
+            (add_to_access(resource_access, access), ...);
+            system_manager->set_resource_access<T>(resource_access);
+        }
+
+        template<typename A, typename B>
+        inline bool systems_conflict() {
+            return system_manager->conflicts<A, B>();
+        }
+
+        // Snapshot of what the ECS is holding; memory_report().to_json() for dumps.
+        inline MemoryReport memory_report() {
+            MemoryReport report;
+            component_manager->memory_report(report);
+            system_manager->memory_report(report);
+            report.entity_bytes = sizeof(EntityManager);
+            for (void* resource : resource_manager->pointers) {
+                if (resource) report.resource_count++;
+            }
+            return report;
+        }
+
+        // Rollback for prediction/reconciliation: keeps the last count
+        // checkpoints of component storage, entity ids, signatures and group
+        // bounds. Component pages are copy-on-write and entities are logged
+        // as they change, so a checkpoint or restore costs what was written
+        // since, not the size of the world. Relations, resources and shared,
+        // split, indexed or buffer components are skipped: a restore leaves
+        // them as they are.
+        inline void enable_checkpoints(size_t count) {
+            assert(count > 0 && "Keep at least one checkpoint");
+            max_checkpoints = count;
+            for (ComponentType type = 0; type < component_manager->next_component_type; type++) {
+                component_manager->arrays_by_type[type]->enable_checkpoints();
+            }
+            entity_history.table.resize(MAX_ENTITIES);
+            for (Entity entity = 0; entity < MAX_ENTITIES; entity++) {
+                entity_history.table[entity] = { entity_manager->next_free[entity].load(std::memory_order_relaxed), entity_manager->signatures[entity] };
+            }
+            entity_manager->clear_changes();
+            entity_manager->track_changes = true;
         }
 
+        // Returns an id for restore_checkpoint.
+        inline uint64_t checkpoint() {
+            assert(max_checkpoints && "Checkpoints not enabled");
+            for (ComponentType type = 0; type < component_manager->next_component_type; type++) {
+                component_manager->arrays_by_type[type]->checkpoint();
+            }
+
+            EntityHistory::Frame frame;
+            frame.free_head = entity_manager->free_head.load();
+            frame.living_entity_count = entity_manager->living_entity_count.load();
+            uint32_t changed = entity_manager->changed_count.load();
+            frame.changes.reserve(changed);
+            for (uint32_t i = 0; i < changed; i++) {
+                Entity entity = entity_manager->changed[i];
+                EntityHistory::Entry& entry = entity_history.table[entity];
+                frame.changes.push_back({ entity, entry });
+                entry = { entity_manager->next_free[entity].load(std::memory_order_relaxed), entity_manager->signatures[entity] };
+            }
+            entity_manager->clear_changes();
+            for (auto const& group : groups) frame.group_sizes.push_back(group->size);
+            entity_history.frames.push_back(std::move(frame));
+
+            if (entity_history.frames.size() > max_checkpoints) {
+                for (ComponentType type = 0; type < component_manager->next_component_type; type++) {
+                    component_manager->arrays_by_type[type]->drop_oldest_checkpoint();
+                }
+                entity_history.frames.pop_front();
+            }
+            return ++latest_checkpoint;
+        }
+
+        // Puts the world back to checkpoint id. Later checkpoints are
+        // discarded; systems see the signature changes that undoes.
+        inline void restore_checkpoint(uint64_t id) {
+            assert(id <= latest_checkpoint && latest_checkpoint - id < entity_history.frames.size() && "Checkpoint no longer retained");
+            size_t back = latest_checkpoint - id;
+            for (ComponentType type = 0; type < component_manager->next_component_type; type++) {
+                component_manager->arrays_by_type[type]->restore_checkpoint(back);
+            }
+
+            // Walk the table back, listing what it touches alongside what
+            // changed since the latest checkpoint; only those are rewritten.
+            for (size_t i = 0; i < back; i++) {
+                for (auto const& change : entity_history.frames.back().changes) {
+                    entity_history.table[change.entity] = change.before;
+                    entity_manager->note_change(change.entity);
+                }
+                entity_history.frames.pop_back();
+            }
+            latest_checkpoint = id;
+
+            uint32_t changed = entity_manager->changed_count.load();
+            for (uint32_t i = 0; i < changed; i++) {
+                Entity entity = entity_manager->changed[i];
+                EntityHistory::Entry const& entry = entity_history.table[entity];
+                Signature current = entity_manager->signatures[entity];
+                if (current != entry.signature) {
+                    system_manager->entity_signature_changed(entity, current, entry.signature);
+                    query_cache->entity_signature_changed(entity, current, entry.signature);
+                    entity_manager->signatures[entity] = entry.signature;
+                }
+                entity_manager->next_free[entity].store(entry.next_free, std::memory_order_relaxed);
+            }
+            entity_manager->clear_changes();
+
+            EntityHistory::Frame const& frame = entity_history.frames.back();
+            entity_manager->free_head.store(frame.free_head);
+            entity_manager->living_entity_count.store(frame.living_entity_count);
+            for (size_t i = 0; i < frame.group_sizes.size(); i++) groups[i]->size = frame.group_sizes[i];
+        }
+
+        // Declares an owning group over Owned. A component can be owned by at
+        // most one group, and its array should not be reordered by anything
+        // else while the group exists.
+        template<typename... Owned>
+        inline std::shared_ptr<Group<Owned...>> group() {
+            Signature owned;
+            (owned.set(component_manager->get_component_type<Owned>()), ...);
+            assert((owned & grouped_components).none() && "Component already owned by another group");
+            grouped_components |= owned;
+
+            auto group = std::make_shared<Group<Owned...>>(owned, component_manager->get_component_array<Owned>()...);
+            auto& first = *std::get<0>(group->arrays);
+            for (size_t i = 0; i < first.size; i++) {
+                Entity entity = first.index_to_entity[i];
+                group->entity_signature_changed(entity, Signature(), entity_manager->get_signature(entity));
+            }
+
+            groups.push_back(group);
+            return group;
+        }
+
+        // Sorts refuse arrays a group owns: the group keeps its members packed
+        // at the front in its own order.
+        template<typename T, typename Compare>
+        inline void sort_components(Compare compare) {
+            assert(!grouped_components.test(get_component_type<T>()) && "Sorting an array owned by a group");
+            ::sort_components(*component_manager->get_component_array<T>(), compare);
+        }
+
+        template<typename T, typename Key>
+        inline void radix_sort_components(Key key) {
+            assert(!grouped_components.test(get_component_type<T>()) && "Sorting an array owned by a group");
+            ::radix_sort_components(*component_manager->get_component_array<T>(), key);
+        }
+
+        // Reorder Follower's storage to match Leader's entity order.
+        template<typename Follower, typename Leader>
+        inline void respect() {
+            assert(!grouped_components.test(get_component_type<Follower>()) && "Sorting an array owned by a group");
+            ::respect(*component_manager->get_component_array<Follower>(), *component_manager->get_component_array<Leader>());
+        }
+
+        // Sorter to be stepped once per frame; Dependents follow T's order.
+        // It checks for groups on every step, so it must not outlive the world.
+        template<typename T, typename... Dependents, typename Compare>
+        inline std::shared_ptr<IncrementalSort<T, Compare>> incremental_sort(Compare compare) {
+            std::vector<std::shared_ptr<IComponentArray>> dependents { component_manager->get_component_array<Dependents>()... };
+            Signature sorted;
+            sorted.set(get_component_type<T>());
+            (sorted.set(get_component_type<Dependents>()), ...);
+            return std::make_shared<IncrementalSort<T, Compare>>(component_manager->get_component_array<T>(), compare, dependents, sorted, &grouped_components);
+        }
+
+        template<typename... Ts>
+        inline void add_to_filter(SystemFilter& filter, With<Ts...>) {
+            (filter.include.set(get_component_type<Ts>()), ...);
+        }
+
+        template<typename... Ts>
+        inline void add_to_filter(SystemFilter& filter, Without<Ts...>) {
+            (filter.exclude.set(get_component_type<Ts>()), ...);
+        }
+
+        template<typename... Ts>
+        inline void add_to_filter(SystemFilter& filter, Optional<Ts...>) {
+            (filter.optional.set(get_component_type<Ts>()), ...);
+        }
+
+        template<typename... Ts>
+        inline void add_to_access(ResourceAccess& access, Read<Ts...>) {
+            (access.read.set(resource_id<Ts>()), ...);
+        }
+
+        template<typename... Ts>
+        inline void add_to_access(ResourceAccess& access, Write<Ts...>) {
+            (access.write.set(resource_id<Ts>()), ...);
+        }
+
+        inline uint64_t rejected(JournalReader& reader, uint64_t ticks) {
+            reader.corrupt = true;
+            return ticks;
+        }
+
+        // data defaults to the stored component. Components whose bytes
+        // aren't their whole value fail the journal rather than record
+        // pointers or half a value.
+        inline void journal_add(Entity entity, ComponentType type, void const* data) {
+            IComponentArray* array = component_manager->arrays_by_type[type];
+            if (!array->serializable()) {
+                journal->fail(readable_type_name(component_manager->type_names[type]) + " keeps state outside its bytes and can't be journaled");
+                return;
+            }
+            if (!data) data = array->raw_data(entity);
+            if (!journal->type_sizes[type]) journal->component_type(type, component_manager->type_names[type], array->component_size());
+            journal->add_component(entity, type, data, array->component_size());
+        }
+
+        inline void groups_signature_changed(Entity entity, Signature old_signature, Signature new_signature) {
+            for (auto const& group : groups) {
+                group->entity_signature_changed(entity, old_signature, new_signature);
+            }
+        }
+
+        // Nodes of this world's index maps and system entity sets. Not
+        // locked: a world is only touched by one thread at a time, and
+        // migration frees into the source's pool and allocates from ours.
+        // Declared first so it outlives everything drawing from it.
+        PoolResource node_pool { NODE_BLOCK_SIZE, 1024 };
         std::unique_ptr<ComponentManager> component_manager;
         std::unique_ptr<EntityManager> entity_manager;
         std::unique_ptr<SystemManager> system_manager;
+        std::unique_ptr<ResourceManager> resource_manager;
+        std::unique_ptr<RelationManager> relation_manager;
+        std::unique_ptr<QueryCache> query_cache;
+        Journal* journal = nullptr; // records structural changes when set
+        std::vector<std::shared_ptr<IGroup>> groups;
+        Signature grouped_components;
+
+        size_t max_checkpoints = 0;
+        uint64_t latest_checkpoint = 0;
+        EntityHistory entity_history;
 };
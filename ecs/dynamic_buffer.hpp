@@ -0,0 +1,232 @@
+#pragma once
+#include "ecs.hpp"
+#include "slot_extension.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Per-world backing store for DynamicBuffers that outgrew their inline
+// storage. Every spilled buffer owns one block of a single contiguous vector
+// and refers to it by handle, so blocks can be slid together by compact()
+// without touching the components. Released space is reclaimed once it
+// makes up more than half of the arena.
+template<typename T>
+class BufferArena {
+    public:
+        static constexpr size_t MIN_COMPACT_SIZE = 4096; // elements
+
+        uint32_t allocate(uint32_t capacity) {
+            uint32_t handle;
+            if (free_handles.empty()) {
+                handle = static_cast<uint32_t>(blocks.size());
+                blocks.push_back({});
+            } else {
+                handle = free_handles.back();
+                free_handles.pop_back();
+            }
+            blocks[handle] = { static_cast<uint32_t>(storage.size()), capacity };
+            storage.resize(storage.size() + capacity);
+            live += capacity;
+            return handle;
+        }
+
+        // Grows in place when the block is the last one, otherwise moves it
+        // to the end.
+        void grow(uint32_t handle, uint32_t capacity) {
+            Block& block = blocks[handle];
+            if (block.offset + block.capacity != storage.size()) {
+                uint32_t offset = static_cast<uint32_t>(storage.size());
+                storage.resize(storage.size() + capacity);
+                std::copy_n(storage.begin() + block.offset, block.capacity, storage.begin() + offset);
+                block.offset = offset;
+            } else {
+                storage.resize(block.offset + capacity);
+            }
+            live += capacity - block.capacity;
+            block.capacity = capacity;
+        }
+
+        void release(uint32_t handle) {
+            live -= blocks[handle].capacity;
+            blocks[handle].capacity = 0;
+            free_handles.push_back(handle);
+            if (storage.size() > MIN_COMPACT_SIZE && live < storage.size() / 2) compact();
+        }
+
+        // Slides live blocks down over released ones. Handles stay valid;
+        // raw pointers from data() do not.
+        void compact() {
+            std::vector<uint32_t> order;
+            for (uint32_t handle = 0; handle < blocks.size(); handle++) {
+                if (blocks[handle].capacity) order.push_back(handle);
+            }
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return blocks[a].offset < blocks[b].offset; });
+
+            uint32_t cursor = 0;
+            for (uint32_t handle : order) {
+                Block& block = blocks[handle];
+                if (block.offset != cursor) {
+                    std::copy_n(storage.begin() + block.offset, block.capacity, storage.begin() + cursor);
+                    block.offset = cursor;
+                }
+                cursor += block.capacity;
+            }
+            storage.resize(cursor);
+            compactions++;
+        }
+
+        T* data(uint32_t handle) {
+            return storage.data() + blocks[handle].offset;
+        }
+
+        size_t live = 0;        // elements held by live blocks
+        size_t compactions = 0;
+
+    private:
+        struct Block {
+            uint32_t offset;
+            uint32_t capacity; // 0 once released
+        };
+
+        std::vector<T> storage;
+        std::vector<Block> blocks;
+        std::vector<uint32_t> free_handles;
+};
+
+// Small variable-length array stored directly in the component. Up to
+// InlineCapacity elements live inline; past that the contents move into the
+// world's BufferArena<T>, so no entity ever does its own malloc. Register
+// with Coordinator::register_buffer, which releases and re-homes spilled
+// storage as the component is removed, destroyed or migrated. Move-only: a
+// spilled block has exactly one owner, and moving from a buffer leaves it
+// empty and inline, so add_component(entity, std::move(buffer)) can't leave
+// the caller holding the block the component now owns.
+template<typename T, uint32_t InlineCapacity>
+struct DynamicBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "DynamicBuffer elements are moved with raw copies");
+    static_assert(InlineCapacity > 0, "Use at least one inline slot");
+
+    using value_type = T;
+
+    DynamicBuffer() = default;
+    DynamicBuffer(DynamicBuffer const&) = delete;
+    DynamicBuffer& operator=(DynamicBuffer const&) = delete;
+
+    DynamicBuffer(DynamicBuffer&& other) noexcept {
+        take(other);
+    }
+
+    // Releases the block this buffer held, if any, before taking other's.
+    DynamicBuffer& operator=(DynamicBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    T* data() {
+        return arena ? arena->data(handle) : inline_data;
+    }
+
+    T& operator[](uint32_t index) {
+        assert(index < size && "DynamicBuffer index out of range");
+        return data()[index];
+    }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size; }
+
+    bool spilled() const {
+        return arena != nullptr;
+    }
+
+    void push_back(T const& value, BufferArena<T>& world) {
+        if (size == capacity) reserve(capacity * 2, world);
+        data()[size++] = value;
+    }
+
+    void pop_back() {
+        assert(size > 0 && "pop_back on empty DynamicBuffer");
+        size--;
+    }
+
+    void clear() {
+        size = 0;
+    }
+
+    void reserve(uint32_t count, BufferArena<T>& world) {
+        if (count <= capacity) return;
+        if (arena) {
+            arena->grow(handle, count);
+        } else {
+            handle = world.allocate(count);
+            std::copy_n(inline_data, size, world.data(handle));
+            arena = &world;
+        }
+        capacity = count;
+    }
+
+    // Called when the component is inserted: a block already in world is
+    // kept as is, one from another world's arena is copied over and released
+    // there.
+    void adopt(BufferArena<T>& world) {
+        if (!arena || arena == &world) return;
+        uint32_t copy = world.allocate(capacity);
+        std::copy_n(arena->data(handle), size, world.data(copy));
+        arena->release(handle);
+        handle = copy;
+        arena = &world;
+    }
+
+    void release() {
+        if (arena) arena->release(handle);
+        arena = nullptr;
+        capacity = InlineCapacity;
+        size = 0;
+    }
+
+    // Moves other's contents here and leaves it empty and inline.
+    void take(DynamicBuffer& other) {
+        size = other.size;
+        capacity = other.capacity;
+        handle = other.handle;
+        arena = other.arena;
+        if (!arena) std::copy_n(other.inline_data, size, inline_data);
+        other.arena = nullptr;
+        other.capacity = InlineCapacity;
+        other.size = 0;
+    }
+
+    uint32_t size = 0;
+    uint32_t capacity = InlineCapacity;
+    uint32_t handle = 0;
+    BufferArena<T>* arena = nullptr; // null while inline
+    T inline_data[InlineCapacity];
+};
+
+// Attached to a DynamicBuffer's ComponentArray by register_buffer: buffers
+// entering the array hand their spilled block to the world's arena, and give
+// it back when destroyed. Buffers migrating out keep theirs; the destination
+// adopts it.
+template<typename Buffer>
+class BufferSlots final : public ISlotExtension<Buffer> {
+    public:
+        BufferSlots(BufferArena<typename Buffer::value_type>& arena) : arena(arena) {}
+
+        void inserted(Entity, size_t, Buffer& buffer) override {
+            buffer.adopt(arena);
+        }
+
+        void removed(Entity, size_t, Buffer& buffer) override {
+            buffer.release();
+        }
+
+        bool bytes_are_value() const override {
+            return false; // raw bytes hold an arena handle
+        }
+
+        BufferArena<typename Buffer::value_type>& arena;
+};
@@ -1,17 +1,41 @@
 #pragma once
+#include "../core/memory.hpp"
+#include "signature.hpp"
 #include <set>
 #include <bitset>
 
 using Entity = std::uint32_t;
 const Entity MAX_ENTITIES = 5000;
+const Entity NO_ENTITY = MAX_ENTITIES;
 
-using ComponentType = std::uint8_t;
-const ComponentType MAX_COMPONENTS = 32;
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 32
+#endif
 
-using Signature = std::bitset<MAX_COMPONENTS>;
+using ComponentType = std::uint16_t;
+const ComponentType MAX_COMPONENTS = ECS_MAX_COMPONENTS;
+
+using Signature = BasicSignature<MAX_COMPONENTS>;
+
+// Block size of each world's node pool (system entity sets, component index
+// maps); big enough for either node.
+const size_t NODE_BLOCK_SIZE = 64;
 
 class System {
     public: 
-        std::set<Entity> entities;
+        // entities draws from the node pool of the world registering the
+        // system, so the system mustn't outlive that world.
+        System() : entities(construction_nodes ? construction_nodes : std::pmr::get_default_resource()) {}
+        virtual ~System() = default;
+
+        // Called by SystemManager right after entities gains or loses an
+        // entity, for systems that keep their own per-entity bookkeeping.
+        virtual void entity_added(Entity) {}
+        virtual void entity_removed(Entity) {}
+
+        std::pmr::set<Entity> entities;
+
+        // Set by SystemManager::register_system while it constructs one.
+        static inline thread_local std::pmr::memory_resource* construction_nodes = nullptr;
 };
 
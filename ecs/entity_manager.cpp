@@ -1,34 +1,104 @@
 #include "entity_manager.hpp"
-#include <iostream>
 #include <assert.h>
 
+static uint64_t pack_head(uint64_t tag, Entity top) {
+    return (tag << 32) | top;
+}
+
 EntityManager::EntityManager() {
     for (Entity entity = 0; entity < MAX_ENTITIES; entity++) {
-        available_entities.push(entity);
+        next_free[entity].store(entity + 1, std::memory_order_relaxed);
+        change_flags[entity].store(0, std::memory_order_relaxed);
     }
+    changed_count.store(0, std::memory_order_relaxed);
 
+    free_head.store(pack_head(0, 0));
     living_entity_count = 0;
 }
 
+uint32_t EntityManager::pop_free(Entity* out, uint32_t max_count) {
+    uint64_t head = free_head.load(std::memory_order_acquire);
+    while (true) {
+        // Walk up to max_count links; if the head is unchanged at the CAS the
+        // walked chain is still ours, since every push/pop bumps the tag.
+        Entity top = static_cast<Entity>(head);
+        uint32_t count = 0;
+        while (top != NO_ENTITY && count < max_count) {
+            out[count++] = top;
+            top = next_free[top].load(std::memory_order_relaxed);
+        }
+        if (count == 0) return 0;
+
+        if (free_head.compare_exchange_weak(head, pack_head((head >> 32) + 1, top), std::memory_order_acquire, std::memory_order_acquire)) {
+            return count;
+        }
+    }
+}
+
+void EntityManager::push_free(Entity const* ids, uint32_t count) {
+    if (count == 0) return;
+    for (uint32_t i = 0; i < count; i++) note_change(ids[i]);
+    for (uint32_t i = 0; i + 1 < count; i++) {
+        next_free[ids[i]].store(ids[i + 1], std::memory_order_relaxed);
+    }
+
+    uint64_t head = free_head.load(std::memory_order_relaxed);
+    do {
+        next_free[ids[count - 1]].store(static_cast<Entity>(head), std::memory_order_relaxed);
+    } while (!free_head.compare_exchange_weak(head, pack_head((head >> 32) + 1, ids[0]), std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::vector<Entity> EntityManager::living_entities() {
+    std::vector<bool> free (MAX_ENTITIES, false);
+    for (Entity id = static_cast<Entity>(free_head.load(std::memory_order_acquire)); id != NO_ENTITY; id = next_free[id].load(std::memory_order_relaxed)) {
+        free[id] = true;
+    }
+    std::vector<Entity> living;
+    for (Entity entity = 0; entity < MAX_ENTITIES; entity++) {
+        if (!free[entity]) living.push_back(entity);
+    }
+    assert(living.size() == living_entity_count.load() && "Ids held by an unflushed LocalCache");
+    return living;
+}
+
 Entity EntityManager::create_entity() {
-    std::cout << living_entity_count << std::endl;
-    assert(living_entity_count < MAX_ENTITIES && "Too many entities exist.");
-    Entity id = available_entities.front();
-    available_entities.pop();
-    living_entity_count++;
+    Entity id;
+    uint32_t popped = pop_free(&id, 1);
+    assert(popped == 1 && "Too many entities exist.");
+    living_entity_count.fetch_add(1, std::memory_order_relaxed);
     return id;
 }
 
 void EntityManager::destroy_entity(Entity entity) {
     assert(entity < MAX_ENTITIES && "Entity out of range.");
     signatures[entity].reset();
-    available_entities.push(entity);
-    living_entity_count--;
+    push_free(&entity, 1);
+    living_entity_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EntityManager::create_entities(Entity* out, uint32_t count) {
+    uint32_t popped = 0;
+    while (popped < count) {
+        uint32_t got = pop_free(out + popped, count - popped);
+        assert(got > 0 && "Too many entities exist.");
+        popped += got;
+    }
+    living_entity_count.fetch_add(count, std::memory_order_relaxed);
+}
+
+void EntityManager::destroy_entities(Entity const* entities, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        assert(entities[i] < MAX_ENTITIES && "Entity out of range.");
+        signatures[entities[i]].reset();
+    }
+    push_free(entities, count);
+    living_entity_count.fetch_sub(count, std::memory_order_relaxed);
 }
 
 void EntityManager::set_signature(Entity entity, Signature signature) {
     assert(entity < MAX_ENTITIES && "Entity out of range.");
     signatures[entity] = signature;
+    note_change(entity);
 }
 
 Signature EntityManager::get_signature(Entity entity) {
@@ -36,6 +106,28 @@ Signature EntityManager::get_signature(Entity entity) {
     return signatures[entity];
 }
 
+Entity EntityManager::LocalCache::create_entity() {
+    if (count == 0) {
+        count = manager.pop_free(ids.data(), BATCH);
+        assert(count > 0 && "Too many entities exist.");
+    }
+    manager.living_entity_count.fetch_add(1, std::memory_order_relaxed);
+    return ids[--count];
+}
 
+void EntityManager::LocalCache::destroy_entity(Entity entity) {
+    assert(entity < MAX_ENTITIES && "Entity out of range.");
+    manager.signatures[entity].reset();
+    manager.note_change(entity);
+    if (count == CAPACITY) {
+        count -= BATCH;
+        manager.push_free(ids.data() + count, BATCH);
+    }
+    ids[count++] = entity;
+    manager.living_entity_count.fetch_sub(1, std::memory_order_relaxed);
+}
 
-
+void EntityManager::LocalCache::flush() {
+    manager.push_free(ids.data(), count);
+    count = 0;
+}
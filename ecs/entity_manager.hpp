@@ -1,17 +1,75 @@
 #pragma once
 #include "ecs.hpp"
-#include <queue>
 #include <array>
+#include <atomic>
+#include <vector>
 
+// Free ids live on a lock-free stack (Treiber stack with a tag in the upper
+// half of the head word to rule out ABA). create_entity/destroy_entity may be
+// called from any thread; threads that spawn a lot should go through a
+// LocalCache so most calls never touch the shared head at all.
 class EntityManager {
     public:
+        // Per-thread stash of free ids, refilled from and spilled to the
+        // global stack in batches with one CAS each. Not shareable between
+        // threads; flushes on destruction.
+        class LocalCache {
+            public:
+                static const uint32_t CAPACITY = 64;
+                static const uint32_t BATCH = 32;
+
+                LocalCache(EntityManager& manager) : manager(manager) {}
+                ~LocalCache() { flush(); }
+
+                Entity create_entity();
+                void destroy_entity(Entity entity);
+                void flush();
+
+                EntityManager& manager;
+                std::array<Entity, CAPACITY> ids;
+                uint32_t count = 0;
+        };
+
         EntityManager();
         Entity create_entity();
         void destroy_entity(Entity entity);
         void set_signature(Entity entity, Signature signature);
         Signature get_signature(Entity entity);
 
-        std::queue<Entity> available_entities;
+        // Batch versions for bulk spawns and migration.
+        void create_entities(Entity* out, uint32_t count);
+        void destroy_entities(Entity const* entities, uint32_t count);
+
+        // Pops up to max_count ids into out, returns how many it got.
+        uint32_t pop_free(Entity* out, uint32_t max_count);
+        // Pushes count ids back with a single CAS.
+        void push_free(Entity const* ids, uint32_t count);
+
+        // Every id not on the free stack, in id order. Needs a quiescent
+        // manager: no concurrent create/destroy and every LocalCache flushed.
+        std::vector<Entity> living_entities();
+
+        // While track_changes is set, every entity whose signature or free
+        // list link is written is listed once in changed, for checkpoints.
+        // Safe from any thread; clear_changes must not race with writers.
+        void note_change(Entity entity) {
+            if (!track_changes || change_flags[entity].exchange(1, std::memory_order_relaxed)) return;
+            changed[changed_count.fetch_add(1, std::memory_order_relaxed)] = entity;
+        }
+
+        void clear_changes() {
+            uint32_t count = changed_count.load(std::memory_order_relaxed);
+            for (uint32_t i = 0; i < count; i++) change_flags[changed[i]].store(0, std::memory_order_relaxed);
+            changed_count.store(0, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<Entity>, MAX_ENTITIES> next_free;
+        std::atomic<uint64_t> free_head; // tag << 32 | top id
         std::array<Signature, MAX_ENTITIES> signatures;
-        uint32_t living_entity_count;
+        std::atomic<uint32_t> living_entity_count;
+
+        bool track_changes = false;
+        std::array<std::atomic<uint8_t>, MAX_ENTITIES> change_flags;
+        std::array<Entity, MAX_ENTITIES> changed;
+        std::atomic<uint32_t> changed_count;
 };
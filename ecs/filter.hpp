@@ -0,0 +1,21 @@
+#pragma once
+#include "ecs.hpp"
+
+// Tags for Coordinator::set_system_filter. An entity joins a system when it
+// has at least one component, every With component and none of the Without
+// ones, so a Without-only filter matches every entity with components.
+// Optional components don't affect membership; they document what the
+// system may read through try_get_component.
+template<typename... Ts> struct With {};
+template<typename... Ts> struct Without {};
+template<typename... Ts> struct Optional {};
+
+struct SystemFilter {
+    Signature include;
+    Signature exclude;
+    Signature optional;
+
+    bool matches(Signature signature) const {
+        return signature.any() && signature.matches(include, exclude);
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include "ecs.hpp"
+#include "component_array.hpp"
+#include <memory>
+#include <tuple>
+
+class IGroup {
+    public:
+        virtual ~IGroup() = default;
+        // Called after a component is added and before one is removed, so a
+        // leaving entity still has a slot in every owned array.
+        virtual void entity_signature_changed(Entity entity, Signature old_signature, Signature new_signature) = 0;
+
+        Signature owned;
+        size_t size = 0;
+};
+
+// Owning group: the first `size` slots of every owned ComponentArray hold the
+// same entities in the same order, so iteration is a lockstep walk over
+// parallel arrays. Membership is kept by swapping entities across the
+// group boundary as they gain or lose one of the owned components.
+template<typename... Owned>
+class Group : public IGroup {
+    public:
+        Group(Signature owned, std::shared_ptr<ComponentArray<Owned>>... arrays) : arrays(arrays...) {
+            this->owned = owned;
+        }
+
+        void entity_signature_changed(Entity entity, Signature old_signature, Signature new_signature) override {
+            bool was_member = (old_signature & owned) == owned;
+            bool is_member = (new_signature & owned) == owned;
+
+            if (!was_member && is_member) {
+                std::apply([&](auto&... array) { (array->swap_entries(array->index_of(entity), size), ...); }, arrays);
+                size++;
+            } else if (was_member && !is_member) {
+                size--;
+                std::apply([&](auto&... array) { (array->swap_entries(array->index_of(entity), size), ...); }, arrays);
+            }
+        }
+
+        // f(Entity, Owned&...)
+        template<typename F>
+        void each(F&& f) {
+            auto& first = *std::get<0>(arrays);
+            std::apply([&](auto&... array) { (array->touch(0, size), ...); }, arrays);
+            for (size_t i = 0; i < size; i++) {
+                std::apply([&](auto&... array) { f(first.index_to_entity[i], array->component_array[i]...); }, arrays);
+            }
+        }
+
+        std::tuple<std::shared_ptr<ComponentArray<Owned>>...> arrays;
+};
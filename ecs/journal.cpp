@@ -0,0 +1,156 @@
+#include "journal.hpp"
+#include <cstring>
+#include <assert.h>
+
+static const char JOURNAL_MAGIC[4] = { 'E', 'C', 'S', 'J' };
+static const uint32_t JOURNAL_VERSION = 2;
+
+Journal::Journal(const char* path) {
+    buffer.reserve(BUFFER_SIZE);
+    file = fopen(path, "wb");
+    if (!file) return;
+    put_bytes(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    put(JOURNAL_VERSION);
+}
+
+Journal::~Journal() {
+    flush();
+    if (file) fclose(file);
+}
+
+void Journal::put_bytes(void const* data, size_t size) {
+    if (buffer.size() + size > BUFFER_SIZE) flush();
+    auto bytes_in = static_cast<uint8_t const*>(data);
+    buffer.insert(buffer.end(), bytes_in, bytes_in + size);
+    bytes += size;
+}
+
+// Pushes everything through to the OS, so a crash or a reader opening the
+// file mid-session only ever misses records still being built.
+void Journal::flush() {
+    if (file && !buffer.empty()) {
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        fflush(file);
+    }
+    buffer.clear();
+}
+
+void Journal::fail(std::string const& reason) {
+    if (!error.empty()) return;
+    error = reason;
+    fprintf(stderr, "journal: %s, recording stopped\n", reason.c_str());
+    flush();
+}
+
+bool Journal::begin(JournalOp op) {
+    if (!error.empty()) return false;
+    put(op);
+    records++;
+    return true;
+}
+
+void Journal::component_type(ComponentType type, const char* name, uint32_t size) {
+    uint16_t length = static_cast<uint16_t>(strlen(name));
+    if (!begin(JournalOp::TYPE)) return;
+    put(type);
+    put(size);
+    put(length);
+    put_bytes(name, length);
+    type_sizes[type] = size;
+}
+
+void Journal::create_entity(Entity entity) {
+    if (!begin(JournalOp::CREATE)) return;
+    put(entity);
+}
+
+void Journal::destroy_entity(Entity entity) {
+    if (!begin(JournalOp::DESTROY)) return;
+    put(entity);
+}
+
+void Journal::add_component(Entity entity, ComponentType type, void const* data, uint32_t size) {
+    if (!begin(JournalOp::ADD)) return;
+    assert(type_sizes[type] == size && "Component type not announced to the journal");
+    put(entity);
+    put(type);
+    put_bytes(data, size);
+}
+
+void Journal::remove_component(Entity entity, ComponentType type) {
+    if (!begin(JournalOp::REMOVE)) return;
+    put(entity);
+    put(type);
+}
+
+void Journal::tick(float dt) {
+    if (!begin(JournalOp::TICK)) return;
+    put(dt);
+}
+
+JournalReader::JournalReader(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length > 0) {
+        contents.resize(static_cast<size_t>(length));
+        contents.resize(fread(contents.data(), 1, contents.size(), file));
+    }
+    fclose(file);
+
+    uint32_t version = 0;
+    valid = contents.size() >= sizeof(JOURNAL_MAGIC) && memcmp(contents.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0;
+    cursor = sizeof(JOURNAL_MAGIC);
+    valid = valid && get(version) && version == JOURNAL_VERSION;
+}
+
+template<typename V>
+bool JournalReader::get(V& value) {
+    if (cursor + sizeof(V) > contents.size()) return false;
+    memcpy(&value, contents.data() + cursor, sizeof(V));
+    cursor += sizeof(V);
+    return true;
+}
+
+bool JournalReader::next(JournalRecord& record) {
+    if (!valid || corrupt || !get(record.op)) return false;
+    if (!read_record(record)) {
+        corrupt = true;
+        return false;
+    }
+    return true;
+}
+
+bool JournalReader::read_record(JournalRecord& record) {
+    switch (record.op) {
+        case JournalOp::TYPE: {
+            if (!get(record.type) || !get(record.size) || !get(record.name_length)) return false;
+            if (record.type >= MAX_COMPONENTS || record.size == 0 || cursor + record.name_length > contents.size()) return false;
+            type_sizes[record.type] = record.size;
+            record.data = contents.data() + cursor;
+            cursor += record.name_length;
+            return true;
+        }
+        case JournalOp::CREATE:
+        case JournalOp::DESTROY:
+            return get(record.entity) && record.entity < MAX_ENTITIES;
+        case JournalOp::ADD:
+            if (!get(record.entity) || !get(record.type)) return false;
+            if (record.entity >= MAX_ENTITIES || record.type >= MAX_COMPONENTS || !type_sizes[record.type]) return false;
+            record.size = type_sizes[record.type];
+            if (cursor + record.size > contents.size()) return false;
+            record.data = contents.data() + cursor;
+            cursor += record.size;
+            return true;
+        case JournalOp::REMOVE:
+            if (!get(record.entity) || !get(record.type)) return false;
+            return record.entity < MAX_ENTITIES && record.type < MAX_COMPONENTS && type_sizes[record.type];
+        case JournalOp::TICK:
+            if (!get(record.dt)) return false;
+            ticks++;
+            return true;
+    }
+    return false;
+}
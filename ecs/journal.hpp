@@ -0,0 +1,101 @@
+#pragma once
+#include "ecs.hpp"
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum class JournalOp : uint8_t {
+    TYPE,    // u16 type, u32 size, u16 name length, name
+    CREATE,  // u32 entity
+    DESTROY, // u32 entity
+    ADD,     // u32 entity, u16 type, component bytes
+    REMOVE,  // u32 entity, u16 type
+    TICK,    // f32 dt
+};
+
+// Append-only binary log of a Coordinator's structural changes, tick by
+// tick, for re-running a session headless (Coordinator::replay). Inputs
+// aren't recorded; the engine has none yet. Component values are written as raw bytes, so
+// journaled components must be trivially copyable. Touching anything the
+// journal can't reproduce (buffer and split components, shared components,
+// relations) while it is attached fails it: the reason goes to stderr and
+// error, and nothing more is recorded, so the file stays a clean prefix of
+// the session. Records are buffered and written out in BUFFER_SIZE chunks.
+class Journal {
+    public:
+        static const size_t BUFFER_SIZE = 64 * 1024;
+
+        Journal(const char* path);
+        ~Journal();
+
+        Journal(const Journal&) = delete;
+        Journal& operator=(const Journal&) = delete;
+
+        void component_type(ComponentType type, const char* name, uint32_t size);
+        void create_entity(Entity entity);
+        void destroy_entity(Entity entity);
+        void add_component(Entity entity, ComponentType type, void const* data, uint32_t size);
+        void remove_component(Entity entity, ComponentType type);
+        void tick(float dt);
+        void flush();
+        // Stops recording for good, keeping what was written so far.
+        void fail(std::string const& reason);
+
+        bool is_open() const {
+            return file != nullptr;
+        }
+
+        std::array<uint32_t, MAX_COMPONENTS> type_sizes {}; // 0 until announced
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+        std::string error; // set by fail()
+
+    private:
+        // Starts a record, or returns false once the journal has failed.
+        bool begin(JournalOp op);
+
+        template<typename V>
+        void put(V value) {
+            put_bytes(&value, sizeof(V));
+        }
+
+        void put_bytes(void const* data, size_t size);
+
+        std::vector<uint8_t> buffer;
+        FILE* file;
+};
+
+struct JournalRecord {
+    JournalOp op;
+    Entity entity = NO_ENTITY;
+    ComponentType type = 0;
+    float dt = 0.0f;
+    uint8_t const* data = nullptr; // component bytes or type name
+    uint32_t size = 0;             // component size
+    uint16_t name_length = 0;      // TYPE only
+};
+
+// Loads a whole journal and walks it record by record.
+class JournalReader {
+    public:
+        JournalReader(const char* path);
+
+        // False at the end, or on a truncated or malformed record (entity or
+        // type out of range, type never announced), which also sets corrupt.
+        bool next(JournalRecord& record);
+
+        bool valid = false;   // file opened and header matched
+        bool corrupt = false; // stopped at a bad record rather than the end
+        uint64_t ticks = 0;   // tick records seen so far
+
+    private:
+        bool read_record(JournalRecord& record);
+
+        template<typename V>
+        bool get(V& value);
+
+        std::vector<uint8_t> contents;
+        std::array<uint32_t, MAX_COMPONENTS> type_sizes {};
+        size_t cursor = 0;
+};
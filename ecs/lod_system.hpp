@@ -0,0 +1,113 @@
+#pragma once
+#include "ecs.hpp"
+#include <array>
+#include <limits>
+#include <vector>
+#include <assert.h>
+
+// One tick-rate band. Entities whose metric is <= max_metric (and above the
+// previous band's) are simulated every `interval` frames. The band is split
+// into `interval` slices by entity id so the work is spread evenly across
+// frames instead of spiking on every interval-th one.
+struct LodBucket {
+    float max_metric;
+    uint32_t interval;
+    std::vector<std::vector<Entity>> slices;
+};
+
+// System that simulates far-away (or otherwise unimportant) entities at a
+// reduced rate. Feed it a metric per entity, typically camera/player distance,
+// with set_lod_metric; an entity only moves between buckets when its band
+// changes. New members start in the first (full rate) bucket. Each entity
+// is handed the time since it last ran, so moving between buckets neither
+// skips nor repeats simulated time.
+//
+//   struct CrowdSystem : LodSystem {
+//       CrowdSystem() { set_buckets({ { 50.f, 1 }, { 200.f, 4 }, { INFINITY, 16 } }); }
+//       void update(float dt) { update_lod(dt, [&](Entity entity, float entity_dt) { step(entity, entity_dt); }); }
+//   };
+class LodSystem : public System {
+    public:
+        static constexpr uint8_t NO_BUCKET = 0xFF;
+
+        LodSystem() {
+            set_buckets({ { std::numeric_limits<float>::infinity(), 1 } });
+            bucket_of.fill(NO_BUCKET);
+        }
+
+        // (max_metric, interval) pairs in increasing metric order; the last
+        // band should be open ended. Must be set before entities join.
+        void set_buckets(std::vector<std::pair<float, uint32_t>> const& bands) {
+            assert(entities.empty() && "Changing LOD buckets with live members");
+            assert(!bands.empty() && bands.size() < NO_BUCKET && "Bad LOD bucket count");
+            buckets.clear();
+            for (auto const& band : bands) {
+                assert(band.second > 0 && "LOD interval must be at least one frame");
+                LodBucket bucket;
+                bucket.max_metric = band.first;
+                bucket.interval = band.second;
+                bucket.slices.resize(band.second);
+                buckets.push_back(std::move(bucket));
+            }
+        }
+
+        void set_lod_metric(Entity entity, float metric) {
+            assert(bucket_of[entity] != NO_BUCKET && "Entity not in this system");
+            size_t bucket = 0;
+            while (bucket + 1 < buckets.size() && metric > buckets[bucket].max_metric) bucket++;
+            if (bucket == bucket_of[entity]) return;
+            unlink(entity);
+            link(entity, bucket);
+        }
+
+        // Runs f(entity, entity_dt) for the slice of every bucket that is due
+        // this frame, entity_dt being the time since that entity last ran (or
+        // joined). f must not add or remove components that change this
+        // system's membership.
+        template<typename F>
+        void update_lod(float dt, F&& f) {
+            frame++;
+            time += dt;
+            for (auto& bucket : buckets) {
+                for (Entity entity : bucket.slices[frame % bucket.interval]) {
+                    f(entity, static_cast<float>(time - last_run[entity]));
+                    last_run[entity] = time;
+                }
+            }
+        }
+
+        void entity_added(Entity entity) override {
+            last_run[entity] = time;
+            link(entity, 0);
+        }
+
+        void entity_removed(Entity entity) override {
+            unlink(entity);
+        }
+
+        std::vector<LodBucket> buckets;
+        uint64_t frame = 0;
+        double time = 0.0; // sum of every dt passed to update_lod
+
+    private:
+        void link(Entity entity, size_t bucket) {
+            auto& slice = buckets[bucket].slices[entity % buckets[bucket].interval];
+            bucket_of[entity] = static_cast<uint8_t>(bucket);
+            slot_of[entity] = static_cast<uint32_t>(slice.size());
+            slice.push_back(entity);
+        }
+
+        void unlink(Entity entity) {
+            uint8_t bucket = bucket_of[entity];
+            auto& slice = buckets[bucket].slices[entity % buckets[bucket].interval];
+            Entity last = slice.back();
+            slice[slot_of[entity]] = last;
+            slot_of[last] = slot_of[entity];
+            slice.pop_back();
+            bucket_of[entity] = NO_BUCKET;
+        }
+
+        std::array<uint8_t, MAX_ENTITIES> bucket_of;
+        std::array<uint32_t, MAX_ENTITIES> slot_of;
+        std::array<double, MAX_ENTITIES> last_run;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "ecs.hpp"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <ostream>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+struct ComponentMemory {
+    std::string name;
+    size_t component_size = 0;
+    size_t count = 0;
+    size_t reserved_bytes = 0;  // packed storage, live or not
+    size_t live_bytes = 0;      // packed storage holding live components
+    size_t index_bytes = 0;     // entity <-> slot maps
+    size_t cold_bytes = 0;      // paged cold half of a split component
+    double fragmentation = 0.0; // share of reserved storage not holding live data
+};
+
+struct MemoryReport {
+    std::vector<ComponentMemory> components;
+    size_t system_count = 0;
+    size_t system_bytes = 0;    // system objects plus their entity sets
+    size_t entity_bytes = 0;    // free list and signatures
+    size_t resource_count = 0;
+
+    size_t component_bytes() const {
+        size_t total = 0;
+        for (auto const& component : components) total += component.reserved_bytes + component.index_bytes + component.cold_bytes;
+        return total;
+    }
+
+    size_t total_bytes() const {
+        return component_bytes() + system_bytes + entity_bytes;
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\"components\":[";
+        for (size_t i = 0; i < components.size(); i++) {
+            auto const& c = components[i];
+            out << (i ? "," : "")
+                << "{\"name\":\"" << c.name << "\""
+                << ",\"component_size\":" << c.component_size
+                << ",\"count\":" << c.count
+                << ",\"reserved_bytes\":" << c.reserved_bytes
+                << ",\"live_bytes\":" << c.live_bytes
+                << ",\"index_bytes\":" << c.index_bytes
+                << ",\"cold_bytes\":" << c.cold_bytes
+                << ",\"fragmentation\":" << c.fragmentation << "}";
+        }
+        out << "],\"system_count\":" << system_count
+            << ",\"system_bytes\":" << system_bytes
+            << ",\"entity_bytes\":" << entity_bytes
+            << ",\"resource_count\":" << resource_count
+            << ",\"component_bytes\":" << component_bytes()
+            << ",\"total_bytes\":" << total_bytes() << "}";
+    }
+
+    std::string to_json() const {
+        std::ostringstream out;
+        write_json(out);
+        return out.str();
+    }
+};
+
+inline std::string readable_type_name(const char* name) {
+#ifdef __GNUG__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+        std::string result (demangled);
+        std::free(demangled);
+        return result;
+    }
+#endif
+    return name;
+}
+
+// Bytes a container node really costs once the world's node pool rounds it up.
+inline size_t pooled_node_bytes(size_t node_size) {
+    return node_size <= NODE_BLOCK_SIZE ? NODE_BLOCK_SIZE : node_size;
+}
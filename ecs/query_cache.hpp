@@ -0,0 +1,103 @@
+#pragma once
+#include "ecs.hpp"
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <assert.h>
+
+// One cached (include, exclude) query. entities is dense and unordered;
+// slot_of makes removal O(1).
+struct CachedQuery {
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    CachedQuery(Signature include, Signature exclude) : include(include), exclude(exclude) {
+        slot_of.fill(NO_SLOT);
+    }
+
+    void add(Entity entity) {
+        slot_of[entity] = static_cast<uint32_t>(entities.size());
+        entities.push_back(entity);
+    }
+
+    void remove(Entity entity) {
+        Entity last = entities.back();
+        entities[slot_of[entity]] = last;
+        slot_of[last] = slot_of[entity];
+        entities.pop_back();
+        slot_of[entity] = NO_SLOT;
+    }
+
+    Signature include;
+    Signature exclude;
+    std::vector<Entity> entities;
+    std::array<uint32_t, MAX_ENTITIES> slot_of;
+};
+
+// Runtime queries for tools and scripts. The first lookup of a mask pair
+// scans the signatures once; after that the entry is kept current from the
+// same signature change events the SystemManager sees, so repeating it
+// costs nothing beyond reading the result.
+class QueryCache {
+    public:
+        struct Key {
+            Signature include;
+            Signature exclude;
+
+            bool operator==(Key const& other) const {
+                return include == other.include && exclude == other.exclude;
+            }
+        };
+
+        struct KeyHash {
+            size_t operator()(Key const& key) const {
+                size_t hash = 0;
+                for (uint64_t word : key.include.words) hash = hash * 31 + std::hash<uint64_t>()(word);
+                for (uint64_t word : key.exclude.words) hash = hash * 31 + std::hash<uint64_t>()(word);
+                return hash;
+            }
+        };
+
+        // signatures: every entity's current signature (dead ones empty).
+        CachedQuery& get(Signature include, Signature exclude, Signature const* signatures) {
+            assert(include.any() && "Query must include at least one component");
+            Key key { include, exclude };
+            auto it = queries.find(key);
+            if (it != queries.end()) return *it->second;
+
+            auto query = std::make_unique<CachedQuery>(include, exclude);
+            for (Entity entity = 0; entity < MAX_ENTITIES; entity++) {
+                if (signatures[entity].matches(include, exclude)) query->add(entity);
+            }
+            CachedQuery& result = *query;
+            queries.emplace(key, std::move(query));
+            return result;
+        }
+
+        void release(Signature include, Signature exclude) {
+            queries.erase(Key { include, exclude });
+        }
+
+        void entity_signature_changed(Entity entity, Signature old_signature, Signature new_signature) {
+            for (auto& [key, query] : queries) {
+                bool was_match = old_signature.matches(query->include, query->exclude);
+                bool is_match = new_signature.matches(query->include, query->exclude);
+                if (was_match == is_match) continue;
+                if (is_match) query->add(entity);
+                else query->remove(entity);
+            }
+        }
+
+        void entity_destroyed(Entity entity, Signature) {
+            for (auto& [key, query] : queries) {
+                if (query->slot_of[entity] != CachedQuery::NO_SLOT) query->remove(entity);
+            }
+        }
+
+        void entities_destroyed(Entity const* entities, Signature const* signatures, size_t count) {
+            if (queries.empty()) return;
+            for (size_t i = 0; i < count; i++) entity_destroyed(entities[i], signatures[i]);
+        }
+
+        std::unordered_map<Key, std::unique_ptr<CachedQuery>, KeyHash> queries;
+};
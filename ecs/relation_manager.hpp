@@ -0,0 +1,113 @@
+#pragma once
+#include "ecs.hpp"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <assert.h>
+
+// Entity -> entity pairs such as ChildOf(parent), Targets(enemy), Owns(item).
+// Both directions are indexed by entity id, so "everything with R(x)" and
+// "what does e point at through R" are O(result).
+class Relation {
+    public:
+        Relation(bool exclusive, bool cascade) : exclusive(exclusive), cascade(cascade), targets_of(MAX_ENTITIES), sources_of(MAX_ENTITIES) {}
+
+        void add(Entity source, Entity target) {
+            assert(source < MAX_ENTITIES && target < MAX_ENTITIES && "Entity out of range.");
+            if (exclusive) {
+                while (!targets_of[source].empty()) remove(source, targets_of[source].back());
+            } else if (has(source, target)) {
+                return;
+            }
+            targets_of[source].push_back(target);
+            sources_of[target].push_back(source);
+        }
+
+        void remove(Entity source, Entity target) {
+            erase_value(targets_of[source], target);
+            erase_value(sources_of[target], source);
+        }
+
+        bool has(Entity source, Entity target) const {
+            auto const& targets = targets_of[source];
+            return std::find(targets.begin(), targets.end(), target) != targets.end();
+        }
+
+        // Drops every pair the entity takes part in.
+        void entity_destroyed(Entity entity) {
+            for (Entity target : targets_of[entity]) erase_value(sources_of[target], entity);
+            for (Entity source : sources_of[entity]) erase_value(targets_of[source], entity);
+            targets_of[entity].clear();
+            sources_of[entity].clear();
+        }
+
+        bool exclusive; // a source has at most one target (ChildOf)
+        bool cascade;   // destroying a target destroys its sources (children)
+        std::vector<std::vector<Entity>> targets_of;
+        std::vector<std::vector<Entity>> sources_of;
+
+    private:
+        static void erase_value(std::vector<Entity>& values, Entity value) {
+            auto it = std::find(values.begin(), values.end(), value);
+            if (it == values.end()) return;
+            *it = values.back();
+            values.pop_back();
+        }
+};
+
+class RelationManager {
+    public:
+        template<typename R>
+        void register_relation(bool exclusive, bool cascade) {
+            const char* type_name = typeid(R).name();
+            assert(relation_indices.find(type_name) == relation_indices.end() && "Relation registered more than once.");
+            relation_indices.insert({ type_name, relations.size() });
+            relations.push_back(std::make_unique<Relation>(exclusive, cascade));
+            any_cascade = any_cascade || cascade;
+        }
+
+        template<typename R>
+        Relation& get_relation() {
+            const char* type_name = typeid(R).name();
+            assert(relation_indices.find(type_name) != relation_indices.end() && "Relation not registered");
+            return *relations[relation_indices[type_name]];
+        }
+
+        bool has_cascade(Entity entity) const {
+            if (!any_cascade) return false;
+            for (auto const& relation : relations) {
+                if (relation->cascade && !relation->sources_of[entity].empty()) return true;
+            }
+            return false;
+        }
+
+        // Appends everything reachable from entities through cascading
+        // relations (children, grandchildren...) to out, each entity once.
+        void collect_cascade(Entity const* entities, size_t count, std::vector<Entity>& out) {
+            std::vector<bool> seen (MAX_ENTITIES, false);
+            for (size_t i = 0; i < count; i++) {
+                if (seen[entities[i]]) continue;
+                seen[entities[i]] = true;
+                out.push_back(entities[i]);
+            }
+            for (size_t next = 0; next < out.size(); next++) {
+                for (auto const& relation : relations) {
+                    if (!relation->cascade) continue;
+                    for (Entity source : relation->sources_of[out[next]]) {
+                        if (seen[source]) continue;
+                        seen[source] = true;
+                        out.push_back(source);
+                    }
+                }
+            }
+        }
+
+        void entity_destroyed(Entity entity) {
+            for (auto const& relation : relations) relation->entity_destroyed(entity);
+        }
+
+        std::vector<std::unique_ptr<Relation>> relations;
+        std::unordered_map<const char*, size_t> relation_indices;
+        bool any_cascade = false;
+};
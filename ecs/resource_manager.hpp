@@ -0,0 +1,71 @@
+#pragma once
+#include "ecs.hpp"
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <assert.h>
+
+const size_t MAX_RESOURCES = 64;
+using ResourceMask = std::bitset<MAX_RESOURCES>;
+
+// Resource ids are handed out once per type for the whole process, so every
+// Coordinator agrees on them and lookups never hash. Atomic because the
+// first use of different types can race on worker threads.
+inline size_t next_resource_id() {
+    static std::atomic<size_t> next { 0 };
+    size_t id = next.fetch_add(1, std::memory_order_relaxed);
+    assert(id < MAX_RESOURCES && "Too many resource types.");
+    return id;
+}
+
+template<typename T>
+size_t resource_id() {
+    static const size_t id = next_resource_id();
+    return id;
+}
+
+// Tags for Coordinator::declare_resource_access.
+template<typename... Ts> struct Read {};
+template<typename... Ts> struct Write {};
+
+struct ResourceAccess {
+    ResourceMask read;
+    ResourceMask write;
+
+    // Two systems may run in parallel unless one writes what the other touches.
+    bool conflicts_with(ResourceAccess const& other) const {
+        return (write & (other.read | other.write)).any() || (other.write & read).any();
+    }
+};
+
+// World-global singletons (camera, time, input, scene parameters). They live
+// outside the component arrays so there is no dummy entity, no sparse lookup
+// and no system membership check: get() is one indexed pointer load.
+class ResourceManager {
+    public:
+        ResourceManager() : pointers(MAX_RESOURCES, nullptr), storage(MAX_RESOURCES) {}
+
+        template<typename T>
+        T& insert(T resource) {
+            size_t id = resource_id<T>();
+            auto stored = std::make_shared<T>(resource);
+            storage[id] = stored;
+            pointers[id] = stored.get();
+            return *stored;
+        }
+
+        template<typename T>
+        void remove() {
+            size_t id = resource_id<T>();
+            storage[id].reset();
+            pointers[id] = nullptr;
+        }
+
+        template<typename T>
+        T* get() {
+            return static_cast<T*>(pointers[resource_id<T>()]);
+        }
+
+        std::vector<void*> pointers;
+        std::vector<std::shared_ptr<void>> storage;
+};
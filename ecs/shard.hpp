@@ -0,0 +1,216 @@
+#pragma once
+#include "coordinator.hpp"
+#include "../core/shared_ring.hpp"
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Name of the ring carrying kind ('m' migrants, 'b' boundary) from shard
+// from to shard to.
+inline std::string shard_ring_name(const char* name, uint32_t from, uint32_t to, char kind) {
+    return "/" + std::string(name) + "-" + std::to_string(from) + "-" + std::to_string(to) + kind;
+}
+
+// Creates the rings between count neighbouring shards; whoever launches the
+// shard processes keeps them alive and they're unlinked when it drops them.
+inline std::vector<std::unique_ptr<SharedRing>> create_shard_rings(const char* name, uint32_t count, size_t ring_bytes = 1 << 20) {
+    std::vector<std::unique_ptr<SharedRing>> rings;
+    for (uint32_t i = 0; i + 1 < count; i++) {
+        for (char kind : { 'm', 'b' }) {
+            rings.push_back(std::make_unique<SharedRing>(shard_ring_name(name, i, i + 1, kind).c_str(), ring_bytes));
+            rings.push_back(std::make_unique<SharedRing>(shard_ring_name(name, i + 1, i, kind).c_str(), ring_bytes));
+        }
+    }
+    return rings;
+}
+
+// One process's part of a world that doesn't fit in one: shard index owns
+// the strip [index * width, (index + 1) * width) along x, with the first and
+// last strips open ended. T places an entity; locate(const T&) returns its
+// position as a std::pair<float, float>. Shards don't run in lockstep.
+//
+// exchange(), once per tick:
+//   - entities whose T left the strip are written, component by component,
+//     into the neighbour's migrant ring and destroyed here. If the ring is
+//     full they stay and are retried next tick. Entities more than a strip
+//     away hop one shard per tick.
+//   - the T of every entity within halo_width of a border is published to
+//     that neighbour's boundary ring as one snapshot.
+//   - incoming migrants are spawned with fresh ids while there is room, and
+//     halo is replaced by the latest snapshot each neighbour published,
+//     which may be a few of its ticks old. Halo is read-only.
+//
+// Components travel as raw bytes and are matched by type id, so every shard
+// must be the same build with the same registration order. A world that
+// registers a kind whose bytes aren't its whole value (buffers, split and
+// shared components) is refused: error names it and is_open() is false.
+template<typename T, typename Locate>
+class Shard {
+    public:
+        static_assert(std::is_trivially_copyable<T>::value, "Boundary state is replicated as raw bytes");
+
+        Shard(const char* name, uint32_t index, uint32_t count, float width, float halo_width, Locate locate, std::function<void(Coordinator&)> setup)
+            : index(index), count(count), width(width), halo_width(halo_width), locate(locate) {
+            world.init();
+            setup(world);
+            array = world.component_manager->template get_component_array<T>();
+            for (ComponentType type = 0; type < world.component_manager->next_component_type; type++) {
+                if (world.component_manager->arrays_by_type[type]->serializable()) continue;
+                error = readable_type_name(world.component_manager->type_names[type]) + " keeps state outside its bytes and can't migrate between shards";
+                return;
+            }
+            for (int side = 0; side < 2; side++) {
+                if (!has_neighbour(side)) continue;
+                uint32_t other = neighbour(side);
+                outgoing[side] = std::make_unique<SharedRing>(shard_ring_name(name, index, other, 'm').c_str());
+                incoming[side] = std::make_unique<SharedRing>(shard_ring_name(name, other, index, 'm').c_str());
+                boundary_out[side] = std::make_unique<SharedRing>(shard_ring_name(name, index, other, 'b').c_str());
+                boundary_in[side] = std::make_unique<SharedRing>(shard_ring_name(name, other, index, 'b').c_str());
+            }
+        }
+
+        // False if a neighbour's rings couldn't be opened or the world was
+        // refused.
+        bool is_open() const {
+            if (!error.empty()) return false;
+            for (int side = 0; side < 2; side++) {
+                if (!has_neighbour(side)) continue;
+                if (!outgoing[side]->is_open() || !incoming[side]->is_open() || !boundary_out[side]->is_open() || !boundary_in[side]->is_open()) return false;
+            }
+            return true;
+        }
+
+        float min_x() const {
+            return index * width;
+        }
+
+        float max_x() const {
+            return (index + 1) * width;
+        }
+
+        void exchange() {
+            assert(error.empty() && "Exchanging on a refused shard");
+            send_migrants();
+            send_boundary();
+            receive_migrants();
+            receive_boundary();
+        }
+
+        Coordinator world;
+        std::shared_ptr<ComponentArray<T>> array;
+        std::vector<T> halo;
+
+        uint32_t index;
+        uint32_t count;
+        float width;
+        float halo_width;
+
+        uint64_t sent = 0;
+        uint64_t received = 0;
+        uint64_t deferred = 0; // sends put off because a ring was full
+        std::string error;     // set when setup registered a kind that can't travel
+
+    private:
+        static constexpr int LEFT = 0;
+        static constexpr int RIGHT = 1;
+
+        bool has_neighbour(int side) const {
+            return side == LEFT ? index > 0 : index + 1 < count;
+        }
+
+        uint32_t neighbour(int side) const {
+            return side == LEFT ? index - 1 : index + 1;
+        }
+
+        void send_migrants() {
+            std::vector<Entity> gone;
+            for (size_t i = 0; i < array->size; i++) {
+                float x = locate(array->component_array[i]).first;
+                int side = x < min_x() ? LEFT : x >= max_x() ? RIGHT : -1;
+                if (side < 0 || !has_neighbour(side)) continue;
+
+                Entity entity = array->index_to_entity[i];
+                encode(entity);
+                if (outgoing[side]->push(message.data(), message.size())) gone.push_back(entity);
+                else deferred++;
+            }
+            sent += gone.size();
+            world.destroy_entities(gone);
+        }
+
+        // u16 type then the component's bytes, for every component it has.
+        void encode(Entity entity) {
+            message.clear();
+            Signature signature = world.entity_manager->get_signature(entity);
+            for (ComponentType type = 0; type < world.component_manager->next_component_type; type++) {
+                if (!signature.test(type)) continue;
+                IComponentArray* components = world.component_manager->arrays_by_type[type];
+                auto bytes = static_cast<uint8_t const*>(components->raw_data(entity));
+                message.insert(message.end(), reinterpret_cast<uint8_t const*>(&type), reinterpret_cast<uint8_t const*>(&type) + sizeof(type));
+                message.insert(message.end(), bytes, bytes + components->component_size());
+            }
+        }
+
+        void send_boundary() {
+            for (int side = 0; side < 2; side++) {
+                if (!has_neighbour(side)) continue;
+                message.clear();
+                for (size_t i = 0; i < array->size; i++) {
+                    T const& component = array->component_array[i];
+                    float x = locate(component).first;
+                    bool near = side == LEFT ? x < min_x() + halo_width : x >= max_x() - halo_width;
+                    if (!near) continue;
+                    auto bytes = reinterpret_cast<uint8_t const*>(&component);
+                    message.insert(message.end(), bytes, bytes + sizeof(T));
+                }
+                if (!boundary_out[side]->push(message.data(), message.size())) deferred++;
+            }
+        }
+
+        void receive_migrants() {
+            for (int side = 0; side < 2; side++) {
+                if (!has_neighbour(side)) continue;
+                // A full shard leaves migrants in the ring, which backs up
+                // into the sender's deferred count.
+                while (world.entity_manager->living_entity_count < MAX_ENTITIES && incoming[side]->pop(message)) {
+                    Entity entity = world.create_entity();
+                    size_t offset = 0;
+                    while (offset < message.size()) {
+                        ComponentType type;
+                        memcpy(&type, message.data() + offset, sizeof(type));
+                        offset += sizeof(type);
+                        assert(type < world.component_manager->next_component_type && "Migrant carries a component this shard never registered");
+                        world.add_component_raw(entity, type, message.data() + offset);
+                        offset += world.component_manager->arrays_by_type[type]->component_size();
+                    }
+                    received++;
+                }
+            }
+        }
+
+        void receive_boundary() {
+            bool changed = false;
+            for (int side = 0; side < 2; side++) {
+                if (!has_neighbour(side)) continue;
+                while (boundary_in[side]->pop(message)) {
+                    neighbour_halo[side].resize(message.size() / sizeof(T));
+                    if (!message.empty()) memcpy(neighbour_halo[side].data(), message.data(), message.size());
+                    changed = true;
+                }
+            }
+            if (!changed) return;
+            halo.assign(neighbour_halo[LEFT].begin(), neighbour_halo[LEFT].end());
+            halo.insert(halo.end(), neighbour_halo[RIGHT].begin(), neighbour_halo[RIGHT].end());
+        }
+
+        Locate locate;
+        std::unique_ptr<SharedRing> outgoing[2];
+        std::unique_ptr<SharedRing> incoming[2];
+        std::unique_ptr<SharedRing> boundary_out[2];
+        std::unique_ptr<SharedRing> boundary_in[2];
+        std::vector<T> neighbour_halo[2];
+        std::vector<uint8_t> message; // scratch
+};
@@ -0,0 +1,190 @@
+#pragma once
+#include "ecs.hpp"
+#include "component_array.hpp"
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+// Component type key for a shared T: With<Shared<Material*>>() filters on it.
+template<typename T>
+struct Shared {};
+
+// Stores each distinct value of T once. Entities hold a reference-counted
+// value id, and the members of every value are kept in their own list so
+// systems can walk value by value (one draw call, one material bind).
+// T needs == and a Hash; values with no members left are recycled.
+template<typename T, typename Hash = std::hash<T>>
+class SharedComponentArray final : public IComponentArray {
+    public:
+        static constexpr uint32_t NO_VALUE = UINT32_MAX;
+
+        SharedComponentArray() {
+            value_of.fill(NO_VALUE);
+        }
+
+        void insert_data(Entity entity, T const& value) {
+            assert(value_of[entity] == NO_VALUE && "Component added to same entity");
+            uint32_t id = acquire(value);
+            value_of[entity] = id;
+            member_slot[entity] = static_cast<uint32_t>(members[id].size());
+            members[id].push_back(entity);
+
+            entity_to_index[entity] = size;
+            index_to_entity[size] = entity;
+            size++;
+        }
+
+        void remove_data(Entity entity) {
+            assert(value_of[entity] != NO_VALUE && "Removing non-existent component");
+            leave_value(entity);
+
+            size_t removed = entity_to_index[entity];
+            Entity last = index_to_entity[size - 1];
+            index_to_entity[removed] = last;
+            entity_to_index[last] = removed;
+            size--;
+        }
+
+        // Moves entity to the group of value; no signature change.
+        void set_data(Entity entity, T const& value) {
+            assert(value_of[entity] != NO_VALUE && "Setting non-existent component");
+            if (values[value_of[entity]] == value) return;
+            leave_value(entity);
+            uint32_t id = acquire(value);
+            value_of[entity] = id;
+            member_slot[entity] = static_cast<uint32_t>(members[id].size());
+            members[id].push_back(entity);
+        }
+
+        T const& get_data(Entity entity) {
+            assert(value_of[entity] != NO_VALUE && "Retrieving non-existent component");
+            return values[value_of[entity]];
+        }
+
+        // f(T const& value, std::vector<Entity> const& entities) once per
+        // distinct value in use.
+        template<typename F>
+        void for_each_group(F&& f) {
+            for (uint32_t id = 0; id < values.size(); id++) {
+                if (!members[id].empty()) f(values[id], members[id]);
+            }
+        }
+
+        size_t distinct_count() const {
+            return lookup.size();
+        }
+
+        void entity_destroyed(Entity entity) override {
+            if (value_of[entity] != NO_VALUE) remove_data(entity);
+        }
+
+        void remove(Entity entity) override {
+            remove_data(entity);
+        }
+
+        uint32_t component_size() override {
+            return sizeof(T);
+        }
+
+        size_t count() override {
+            return size;
+        }
+
+        Entity entity_at(size_t index) override {
+            return index_to_entity[index];
+        }
+
+        bool contains(Entity entity) override {
+            return value_of[entity] != NO_VALUE;
+        }
+
+        size_t index_of(Entity entity) override {
+            return entity_to_index[entity];
+        }
+
+        // Only the flat entity order is swapped; value groups are unaffected.
+        void swap_entries(size_t a, size_t b) override {
+            Entity entity_a = index_to_entity[a];
+            Entity entity_b = index_to_entity[b];
+            index_to_entity[a] = entity_b;
+            index_to_entity[b] = entity_a;
+            entity_to_index[entity_a] = b;
+            entity_to_index[entity_b] = a;
+        }
+
+        void migrate_to(IComponentArray& destination, Entity const* remap) override {
+            auto& other = static_cast<SharedComponentArray<T, Hash>&>(destination);
+            size_t kept = 0;
+            for (size_t i = 0; i < size; i++) {
+                Entity entity = index_to_entity[i];
+                Entity moved = remap[entity];
+                if (moved != NO_ENTITY) {
+                    other.insert_data(moved, values[value_of[entity]]);
+                    leave_value(entity);
+                } else {
+                    index_to_entity[kept] = entity;
+                    entity_to_index[entity] = kept;
+                    kept++;
+                }
+            }
+            size = kept;
+        }
+
+        ComponentMemory memory_usage() override {
+            ComponentMemory usage;
+            usage.component_size = sizeof(T);
+            usage.count = size;
+            usage.reserved_bytes = values.capacity() * sizeof(T);
+            usage.live_bytes = lookup.size() * sizeof(T);
+            usage.index_bytes = sizeof(value_of) + sizeof(member_slot) + sizeof(entity_to_index) + sizeof(index_to_entity)
+                + lookup.bucket_count() * sizeof(void*) + lookup.size() * (sizeof(void*) + sizeof(std::pair<const T, uint32_t>));
+            for (auto const& list : members) usage.index_bytes += list.capacity() * sizeof(Entity);
+            usage.fragmentation = usage.reserved_bytes ? 1.0 - double(usage.live_bytes) / double(usage.reserved_bytes) : 0.0;
+            return usage;
+        }
+
+        std::vector<T> values;
+        std::vector<std::vector<Entity>> members; // by value id
+        std::array<uint32_t, MAX_ENTITIES> value_of;
+        size_t size = 0;
+
+    private:
+        uint32_t acquire(T const& value) {
+            auto it = lookup.find(value);
+            if (it != lookup.end()) return it->second;
+
+            uint32_t id;
+            if (free_ids.empty()) {
+                id = static_cast<uint32_t>(values.size());
+                values.push_back(value);
+                members.emplace_back();
+            } else {
+                id = free_ids.back();
+                free_ids.pop_back();
+                values[id] = value;
+            }
+            lookup.insert({ value, id });
+            return id;
+        }
+
+        void leave_value(Entity entity) {
+            uint32_t id = value_of[entity];
+            auto& list = members[id];
+            Entity last = list.back();
+            list[member_slot[entity]] = last;
+            member_slot[last] = member_slot[entity];
+            list.pop_back();
+            value_of[entity] = NO_VALUE;
+
+            if (list.empty()) {
+                lookup.erase(values[id]);
+                free_ids.push_back(id);
+            }
+        }
+
+        std::unordered_map<T, uint32_t, Hash> lookup;
+        std::vector<uint32_t> free_ids;
+        std::array<uint32_t, MAX_ENTITIES> member_slot;
+        std::array<size_t, MAX_ENTITIES> entity_to_index;
+        std::array<Entity, MAX_ENTITIES> index_to_entity;
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Fixed-width component mask stored as 64-bit words, aligned so the whole
+// mask is one vector load at 128 (SSE2) or 256 (AVX2) bits. Width comes from
+// MAX_COMPONENTS in ecs.hpp (-DECS_MAX_COMPONENTS=128 or 256).
+template<size_t BITS>
+class BasicSignature {
+    public:
+        static constexpr size_t WORDS = (BITS + 63) / 64;
+        static constexpr size_t ALIGNMENT = WORDS >= 4 ? 32 : (WORDS >= 2 ? 16 : 8);
+
+        BasicSignature& set(size_t bit, bool value = true) {
+            uint64_t mask = uint64_t(1) << (bit % 64);
+            if (value) {
+                words[bit / 64] |= mask;
+            } else {
+                words[bit / 64] &= ~mask;
+            }
+            return *this;
+        }
+
+        bool test(size_t bit) const {
+            return (words[bit / 64] >> (bit % 64)) & 1;
+        }
+
+        void reset() {
+            words.fill(0);
+        }
+
+        bool none() const {
+            uint64_t any = 0;
+            for (size_t w = 0; w < WORDS; w++) any |= words[w];
+            return any == 0;
+        }
+
+        bool any() const {
+            return !none();
+        }
+
+        BasicSignature& operator|=(BasicSignature const& other) {
+            for (size_t w = 0; w < WORDS; w++) words[w] |= other.words[w];
+            return *this;
+        }
+
+        BasicSignature& operator&=(BasicSignature const& other) {
+            for (size_t w = 0; w < WORDS; w++) words[w] &= other.words[w];
+            return *this;
+        }
+
+        friend BasicSignature operator|(BasicSignature a, BasicSignature const& b) { return a |= b; }
+        friend BasicSignature operator&(BasicSignature a, BasicSignature const& b) { return a &= b; }
+
+        friend bool operator==(BasicSignature const& a, BasicSignature const& b) {
+            uint64_t diff = 0;
+            for (size_t w = 0; w < WORDS; w++) diff |= a.words[w] ^ b.words[w];
+            return diff == 0;
+        }
+
+        friend bool operator!=(BasicSignature const& a, BasicSignature const& b) { return !(a == b); }
+
+        // Has every bit of include and no bit of exclude, without building
+        // temporaries: one vector op per 128/256 bits where available.
+        bool matches(BasicSignature const& include, BasicSignature const& exclude) const {
+#if defined(__AVX2__)
+            if constexpr (WORDS % 4 == 0) {
+                __m256i miss = _mm256_setzero_si256();
+                for (size_t w = 0; w < WORDS; w += 4) {
+                    __m256i s = _mm256_load_si256(reinterpret_cast<__m256i const*>(&words[w]));
+                    __m256i i = _mm256_load_si256(reinterpret_cast<__m256i const*>(&include.words[w]));
+                    __m256i e = _mm256_load_si256(reinterpret_cast<__m256i const*>(&exclude.words[w]));
+                    miss = _mm256_or_si256(miss, _mm256_or_si256(_mm256_andnot_si256(s, i), _mm256_and_si256(s, e)));
+                }
+                return _mm256_testz_si256(miss, miss);
+            }
+#endif
+#if defined(__SSE2__)
+            if constexpr (WORDS % 2 == 0) {
+                __m128i miss = _mm_setzero_si128();
+                for (size_t w = 0; w < WORDS; w += 2) {
+                    __m128i s = _mm_load_si128(reinterpret_cast<__m128i const*>(&words[w]));
+                    __m128i i = _mm_load_si128(reinterpret_cast<__m128i const*>(&include.words[w]));
+                    __m128i e = _mm_load_si128(reinterpret_cast<__m128i const*>(&exclude.words[w]));
+                    miss = _mm_or_si128(miss, _mm_or_si128(_mm_andnot_si128(s, i), _mm_and_si128(s, e)));
+                }
+                return _mm_movemask_epi8(_mm_cmpeq_epi8(miss, _mm_setzero_si128())) == 0xFFFF;
+            }
+#endif
+            uint64_t miss = 0;
+            for (size_t w = 0; w < WORDS; w++) miss |= (~words[w] & include.words[w]) | (words[w] & exclude.words[w]);
+            return miss == 0;
+        }
+
+        alignas(ALIGNMENT) std::array<uint64_t, WORDS> words {};
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "ecs.hpp"
+
+template<typename T> class ComponentArray;
+
+// State kept beside a ComponentArray<T>'s packed slots that has to follow
+// every change to them: the cold half of a split component, the arena
+// blocks of a DynamicBuffer, secondary indexes, checkpoint history. Plain
+// components have none. Attached with ComponentArray::attach, called in
+// attach order.
+template<typename T>
+class ISlotExtension {
+    public:
+        virtual ~ISlotExtension() = default;
+
+        // component now sits in slot: added, or migrated in from another world.
+        virtual void inserted(Entity, size_t, T&) {}
+        // component in slot is about to be destroyed.
+        virtual void removed(Entity, size_t, T&) {}
+        // component in slot moved to destination's slot to, where inserted
+        // has already run.
+        virtual void departed(Entity, size_t, ComponentArray<T>&, size_t) {}
+        virtual void moved(size_t, size_t) {} // to takes from's value
+        virtual void swapped(size_t, size_t) {}
+        // Slots [begin, end) handed out for writing.
+        virtual void touched(size_t, size_t) {}
+        // A write reported through set_component/patch_component/mark_changed.
+        virtual void changed(Entity, T const&) {}
+
+        // False when the component's bytes aren't its whole value; the array
+        // then can't be journaled or sent between shards.
+        virtual bool bytes_are_value() const { return true; }
+        // True when in-place writes must be reported through changed().
+        virtual bool watches_writes() const { return false; }
+        virtual size_t memory_usage() { return 0; }
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include "ecs.hpp"
+#include "component_array.hpp"
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+// Moves slots so that slot i ends up holding what was at order[i].
+inline void apply_order(IComponentArray& array, std::vector<size_t> const& order) {
+    size_t count = order.size();
+    std::vector<size_t> position (count); // original slot -> current slot
+    std::vector<size_t> at (count);       // current slot -> original slot
+    std::iota(position.begin(), position.end(), 0);
+    std::iota(at.begin(), at.end(), 0);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t from = position[order[i]];
+        if (from == i) continue;
+        array.swap_entries(i, from);
+        size_t displaced = at[i];
+        at[from] = displaced;
+        position[displaced] = from;
+        at[i] = order[i];
+        position[order[i]] = i;
+    }
+}
+
+// Full in-place sort by compare(const T&, const T&). These free functions
+// don't know about groups; the Coordinator wrappers refuse grouped arrays.
+template<typename T, typename Compare>
+void sort_components(ComponentArray<T>& array, Compare compare) {
+    std::vector<size_t> order (array.size);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return compare(array.component_array[a], array.component_array[b]);
+    });
+    apply_order(array, order);
+}
+
+// LSD radix sort by an unsigned integer key(const T&), e.g. a packed
+// (material, mesh) id or a Morton code of the position.
+template<typename T, typename Key>
+void radix_sort_components(ComponentArray<T>& array, Key key) {
+    using KeyType = decltype(key(array.component_array[0]));
+    size_t count = array.size;
+
+    std::vector<KeyType> keys (count);
+    std::vector<size_t> order (count);
+    std::vector<size_t> scratch (count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = key(array.component_array[i]);
+        order[i] = i;
+    }
+
+    for (size_t shift = 0; shift < sizeof(KeyType) * 8; shift += 8) {
+        size_t buckets[257] = {};
+        for (size_t i = 0; i < count; i++) buckets[((keys[order[i]] >> shift) & 0xFF) + 1]++;
+        if (std::find(buckets + 1, buckets + 257, count) != buckets + 257) continue; // every key shares this byte
+        for (size_t b = 1; b < 257; b++) buckets[b] += buckets[b - 1];
+        for (size_t i = 0; i < count; i++) scratch[buckets[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+        order.swap(scratch);
+    }
+
+    apply_order(array, order);
+}
+
+// Reorders follower so the entities it shares with leader appear first, in
+// leader's order.
+inline void respect(IComponentArray& follower, IComponentArray& leader) {
+    size_t next = 0;
+    for (size_t i = 0; i < leader.count(); i++) {
+        Entity entity = leader.entity_at(i);
+        if (follower.contains(entity)) follower.swap_entries(follower.index_of(entity), next++);
+    }
+}
+
+// Keeps an array (and its dependents) sorted a few swaps at a time so it can
+// stay on during gameplay. Insertion sort is used because swap-removes only
+// disturb a handful of slots per frame and it is cheap on nearly sorted data.
+// Like the full sorts, it refuses arrays owned by a group, including ones
+// that joined a group after the sort was set up: sorted holds the types of
+// array and dependents, grouped the world's grouped types.
+template<typename T, typename Compare>
+class IncrementalSort {
+    public:
+        IncrementalSort(std::shared_ptr<ComponentArray<T>> array, Compare compare, std::vector<std::shared_ptr<IComponentArray>> dependents, Signature sorted, Signature const* grouped)
+            : array(array), compare(compare), dependents(dependents), sorted(sorted), grouped(grouped) {
+            assert((sorted & *grouped).none() && "Sorting an array owned by a group");
+        }
+
+        // Does at most max_swaps swaps and stops at the end of a pass, so a
+        // call never compares more than one pass worth of slots. Returns the
+        // number of swaps made.
+        size_t step(size_t max_swaps) {
+            assert((sorted & *grouped).none() && "Sorting an array owned by a group");
+            size_t swaps = 0;
+
+            while (swaps < max_swaps) {
+                if (cursor >= array->size) {
+                    next_phase();
+                    if (phase == 0) {
+                        passes++;
+                        break;
+                    }
+                    continue;
+                }
+
+                if (phase == 0) {
+                    if (probe > 0 && compare(array->component_array[probe], array->component_array[probe - 1])) {
+                        array->swap_entries(probe, probe - 1);
+                        probe--;
+                        swaps++;
+                    } else {
+                        cursor++;
+                        probe = cursor;
+                    }
+                    continue;
+                }
+
+                IComponentArray& follower = *dependents[phase - 1];
+                Entity entity = array->index_to_entity[cursor++];
+                if (!follower.contains(entity)) continue;
+                if (probe >= follower.count()) {
+                    // follower shrank under us; pick it up again next pass
+                    cursor = array->size;
+                    continue;
+                }
+                size_t index = follower.index_of(entity);
+                if (index != probe) {
+                    follower.swap_entries(index, probe);
+                    swaps++;
+                }
+                probe++;
+            }
+
+            return swaps;
+        }
+
+        std::shared_ptr<ComponentArray<T>> array;
+        Compare compare;
+        std::vector<std::shared_ptr<IComponentArray>> dependents;
+        size_t passes = 0; // completed full passes over array and dependents
+
+    private:
+        void next_phase() {
+            phase = (phase + 1) % (dependents.size() + 1);
+            cursor = phase == 0 ? 1 : 0;
+            probe = cursor;
+        }
+
+        Signature sorted;
+        Signature const* grouped;
+        size_t phase = 0;  // 0 sorts array, k > 0 aligns dependents[k - 1]
+        size_t cursor = 1;
+        size_t probe = 1;
+};
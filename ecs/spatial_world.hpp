@@ -0,0 +1,230 @@
+#pragma once
+#include "coordinator.hpp"
+#include "../core/jobs.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A large world split into a grid of cells, each a Coordinator of its own,
+// so cells simulate on separate workers without sharing any storage. T is
+// the component that places an entity and that neighbours need to see (e.g.
+// position and radius); locate(const T&) returns its ground-plane position as
+// a std::pair<float, float>. Entities whose T moved out of their cell are
+// bulk migrated at the tick boundary, which changes their ids.
+//
+// Each cell reads its neighbours only through halo: copies of the T of
+// every neighbouring entity within halo_width of the cell, rebuilt at every
+// exchange. A cell is still bounded by MAX_ENTITIES, so more cells also means
+// more room.
+//
+//   SpatialWorld<Body, decltype(locate)> world (16, 16, 50.f, 2.f, locate, [](Coordinator& cell) {
+//       cell.register_component<Body>();
+//   });
+//   world.step(jobs, dt, [](auto& cell, float dt) { collide(cell.world, cell.halo, dt); });
+template<typename T, typename Locate>
+class SpatialWorld {
+    public:
+        struct Cell {
+            Coordinator world;
+            uint32_t x, y;
+            float min_x, min_y, max_x, max_y;
+            std::shared_ptr<ComponentArray<T>> array;
+            std::vector<T> halo; // read-only, valid until the next exchange
+
+            // (destination cell, entity) for entities that left, sorted
+            std::vector<std::pair<uint32_t, Entity>> leaving;
+        };
+
+        // setup registers components and systems on every cell; all cells
+        // must end up with the same component types, T among them.
+        SpatialWorld(uint32_t columns, uint32_t rows, float cell_size, float halo_width, Locate locate, std::function<void(Coordinator&)> setup)
+            : columns(columns), rows(rows), cell_size(cell_size), halo_width(halo_width), locate(locate) {
+            assert(columns > 0 && rows > 0 && "Empty spatial grid");
+            assert(halo_width <= cell_size && "Halo wider than a cell");
+            for (uint32_t y = 0; y < rows; y++) {
+                for (uint32_t x = 0; x < columns; x++) {
+                    auto cell = std::make_unique<Cell>();
+                    cell->x = x;
+                    cell->y = y;
+                    cell->min_x = x * cell_size;
+                    cell->min_y = y * cell_size;
+                    cell->max_x = cell->min_x + cell_size;
+                    cell->max_y = cell->min_y + cell_size;
+                    cell->world.init();
+                    setup(cell->world);
+                    cell->array = cell->world.component_manager->template get_component_array<T>();
+                    cells.push_back(std::move(cell));
+                }
+            }
+        }
+
+        size_t cell_count() const {
+            return cells.size();
+        }
+
+        Cell& cell(uint32_t index) {
+            return *cells[index];
+        }
+
+        // Positions off the grid belong to the nearest edge cell.
+        uint32_t cell_index(float x, float y) const {
+            int column = std::clamp(static_cast<int>(std::floor(x / cell_size)), 0, static_cast<int>(columns) - 1);
+            int row = std::clamp(static_cast<int>(std::floor(y / cell_size)), 0, static_cast<int>(rows) - 1);
+            return row * columns + column;
+        }
+
+        Cell& cell_at(float x, float y) {
+            return *cells[cell_index(x, y)];
+        }
+
+        // Spawns into the cell that owns component's position.
+        std::pair<uint32_t, Entity> create_entity(T component) {
+            auto [x, y] = locate(component);
+            uint32_t index = cell_index(x, y);
+            Coordinator& world = cells[index]->world;
+            Entity entity = world.create_entity();
+            world.add_component(entity, component);
+            return { index, entity };
+        }
+
+        // One tick: simulate(cell, dt) for every cell as its own job, then the
+        // boundary exchange. simulate may only touch its cell's world and read
+        // its halo.
+        template<typename Simulate>
+        void step(JobSystem& jobs, float dt, Simulate&& simulate) {
+            std::vector<uint32_t> all (cells.size());
+            for (uint32_t i = 0; i < all.size(); i++) all[i] = i;
+            run_cells(jobs, all, "cell simulate", [&](uint32_t index) { simulate(*cells[index], dt); });
+            exchange(jobs);
+        }
+
+        // Moves every entity whose T left its cell to the owning cell, then
+        // rebuilds halos. Cells are pulled into in nine passes, one per (x % 3,
+        // y % 3) colour, so concurrent pulls never share a neighbour. The rare
+        // entity that jumped past a neighbour is moved afterwards on the
+        // calling thread.
+        void exchange(JobSystem& jobs) {
+            std::vector<uint32_t> all (cells.size());
+            for (uint32_t i = 0; i < all.size(); i++) all[i] = i;
+            run_cells(jobs, all, "cell scan", [&](uint32_t index) { collect_leaving(index); });
+
+            for (uint32_t colour = 0; colour < 9; colour++) {
+                std::vector<uint32_t> pass;
+                for (uint32_t index = 0; index < cells.size(); index++) {
+                    Cell& cell = *cells[index];
+                    if ((cell.y % 3) * 3 + cell.x % 3 == colour) pass.push_back(index);
+                }
+                run_cells(jobs, pass, "cell migrate", [&](uint32_t index) { pull_neighbours(index); });
+            }
+
+            for (uint32_t source = 0; source < cells.size(); source++) {
+                auto& leaving = cells[source]->leaving;
+                for (size_t i = 0; i < leaving.size();) {
+                    uint32_t destination = leaving[i].first;
+                    size_t end = i;
+                    while (end < leaving.size() && leaving[end].first == destination) end++;
+                    if (!adjacent(source, destination)) move(source, destination, leaving.data() + i, end - i);
+                    i = end;
+                }
+                leaving.clear();
+            }
+
+            run_cells(jobs, all, "cell halo", [&](uint32_t index) { gather_halo(index); });
+        }
+
+        // Called after each bulk move with the old and new ids, e.g. to fix up
+        // handles held outside the world. Runs on worker threads, possibly
+        // for several destinations at once.
+        std::function<void(uint32_t from, uint32_t to, std::vector<Entity> const& old_ids, std::vector<Entity> const& new_ids)> on_migrated;
+
+        uint32_t columns;
+        uint32_t rows;
+        float cell_size;
+        float halo_width;
+        std::atomic<uint64_t> migrated { 0 }; // entities moved between cells so far
+
+    private:
+        template<typename F>
+        void run_cells(JobSystem& jobs, std::vector<uint32_t> const& indices, const char* name, F&& f) {
+            if (indices.empty()) return;
+            std::vector<Job> batch;
+            batch.reserve(indices.size());
+            for (uint32_t index : indices) batch.push_back(Job { [&f, index] { f(index); }, name });
+            JobCounter counter;
+            jobs.run(batch.data(), batch.size(), &counter);
+            jobs.wait(counter);
+        }
+
+        bool adjacent(uint32_t a, uint32_t b) const {
+            Cell const& first = *cells[a];
+            Cell const& second = *cells[b];
+            return std::abs(static_cast<int>(first.x) - static_cast<int>(second.x)) <= 1
+                && std::abs(static_cast<int>(first.y) - static_cast<int>(second.y)) <= 1;
+        }
+
+        void collect_leaving(uint32_t index) {
+            Cell& cell = *cells[index];
+            ComponentArray<T>& array = *cell.array;
+            for (size_t i = 0; i < array.size; i++) {
+                auto [x, y] = locate(array.component_array[i]);
+                uint32_t owner = cell_index(x, y);
+                if (owner != index) cell.leaving.push_back({ owner, array.index_to_entity[i] });
+            }
+            std::sort(cell.leaving.begin(), cell.leaving.end());
+        }
+
+        void pull_neighbours(uint32_t destination) {
+            Cell& cell = *cells[destination];
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int x = static_cast<int>(cell.x) + dx;
+                    int y = static_cast<int>(cell.y) + dy;
+                    if ((dx == 0 && dy == 0) || x < 0 || y < 0 || x >= static_cast<int>(columns) || y >= static_cast<int>(rows)) continue;
+
+                    uint32_t source = y * columns + x;
+                    auto& leaving = cells[source]->leaving;
+                    auto first = std::lower_bound(leaving.begin(), leaving.end(), std::pair<uint32_t, Entity>(destination, 0));
+                    auto last = std::lower_bound(first, leaving.end(), std::pair<uint32_t, Entity>(destination + 1, 0));
+                    if (first != last) move(source, destination, &*first, last - first);
+                }
+            }
+        }
+
+        void move(uint32_t source, uint32_t destination, std::pair<uint32_t, Entity> const* leaving, size_t count) {
+            std::vector<Entity> entities (count);
+            for (size_t i = 0; i < count; i++) entities[i] = leaving[i].second;
+            std::vector<Entity> moved = cells[destination]->world.migrate_entities(cells[source]->world, entities);
+            migrated.fetch_add(count, std::memory_order_relaxed);
+            if (on_migrated) on_migrated(source, destination, entities, moved);
+        }
+
+        void gather_halo(uint32_t index) {
+            Cell& cell = *cells[index];
+            cell.halo.clear();
+            float min_x = cell.min_x - halo_width;
+            float min_y = cell.min_y - halo_width;
+            float max_x = cell.max_x + halo_width;
+            float max_y = cell.max_y + halo_width;
+
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int x = static_cast<int>(cell.x) + dx;
+                    int y = static_cast<int>(cell.y) + dy;
+                    if ((dx == 0 && dy == 0) || x < 0 || y < 0 || x >= static_cast<int>(columns) || y >= static_cast<int>(rows)) continue;
+
+                    ComponentArray<T>& array = *cells[y * columns + x]->array;
+                    for (size_t i = 0; i < array.size; i++) {
+                        auto [px, py] = locate(array.component_array[i]);
+                        if (px >= min_x && px < max_x && py >= min_y && py < max_y) cell.halo.push_back(array.component_array[i]);
+                    }
+                }
+            }
+        }
+
+        Locate locate;
+        std::vector<std::unique_ptr<Cell>> cells;
+};
@@ -1,48 +1,220 @@
 #pragma once
 #include "ecs.hpp"
+#include "filter.hpp"
+#include "resource_manager.hpp"
+#include "memory_report.hpp"
+#include <array>
 #include <unordered_map>
+#include <vector>
 #include <memory>
 #include <assert.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 class SystemManager {
     public:
+        // nodes backs the systems' entity sets; it must outlive this manager.
+        SystemManager(std::pmr::memory_resource* nodes) : nodes(nodes) {}
+
         template<typename T>
         std::shared_ptr<T> register_system() {
             const char* type_name = typeid(T).name();
-            assert(systems.find(type_name) == systems.end() && "Registering system more than once");
+            assert(system_indices.find(type_name) == system_indices.end() && "Registering system more than once");
+            System::construction_nodes = nodes;
             auto system = std::make_shared<T>();
-            systems.insert({ type_name, system });
+            System::construction_nodes = nullptr;
+            system_indices.insert({ type_name, systems.size() });
+            systems.push_back(system);
+            include_masks.push_back(Signature());
+            exclude_masks.push_back(Signature());
+            optional_masks.push_back(Signature());
+            size_t padded = (systems.size() + 3) / 4 * 4;
+            for (size_t w = 0; w < Signature::WORDS; w++) {
+                include_table[w].resize(padded);
+                exclude_table[w].resize(padded);
+            }
+            resource_access.push_back(ResourceAccess());
+            old_matches.resize((systems.size() + 63) / 64);
+            new_matches.resize((systems.size() + 63) / 64);
             return system;
         }
 
         template<typename T>
-        void set_signature(Signature signature) {
+        void set_signature(Signature signature, Signature const* signatures) {
+            SystemFilter filter;
+            filter.include = signature;
+            set_filter<T>(filter, signatures);
+        }
+
+        // signatures: every entity's current signature (dead ones empty).
+        // Entities that already exist join or leave the system to match the
+        // new filter, same as if they'd been built after it was set.
+        template<typename T>
+        void set_filter(SystemFilter filter, Signature const* signatures) {
+            size_t index = get_system_index<T>();
+            include_masks[index] = filter.include;
+            exclude_masks[index] = filter.exclude;
+            optional_masks[index] = filter.optional;
+            for (size_t w = 0; w < Signature::WORDS; w++) {
+                include_table[w][index] = filter.include.words[w];
+                exclude_table[w][index] = filter.exclude.words[w];
+            }
+
+            std::pmr::set<Entity>& entities = systems[index]->entities;
+            for (auto it = entities.begin(); it != entities.end();) {
+                Entity entity = *it++;
+                if (!filter.matches(signatures[entity])) remove_from(index, entity);
+            }
+            for (Entity entity = 0; entity < MAX_ENTITIES; entity++) {
+                if (filter.matches(signatures[entity])) add_to(index, entity);
+            }
+        }
+
+        template<typename T>
+        void set_resource_access(ResourceAccess access) {
+            resource_access[get_system_index<T>()] = access;
+        }
+
+        // True when A and B can't be scheduled concurrently.
+        template<typename A, typename B>
+        bool conflicts() {
+            return resource_access[get_system_index<A>()].conflicts_with(resource_access[get_system_index<B>()]);
+        }
+
+        template<typename T>
+        size_t get_system_index() {
             const char* type_name = typeid(T).name();
-            assert(systems.find(type_name) != systems.end() && "System used before registering");
-            signatures.insert({ type_name, signature });
+            assert(system_indices.find(type_name) != system_indices.end() && "System used before registering");
+            return system_indices[type_name];
+        }
+
+        // One bit per system, set where signature passes that system's
+        // filter (SystemFilter::matches). Filters are packed word-major, so
+        // each vector compare tests one signature word against 4 systems
+        // (AVX2) or 2 (SSE2) at any signature width.
+        void match_systems(Signature const& signature, uint64_t* out) {
+            size_t count = systems.size();
+            for (size_t base = 0; base < count; base += 64) {
+                size_t n = count - base < 64 ? count - base : 64;
+                uint64_t bits = signature.none() ? 0 : ~uint64_t(0) >> (64 - n);
+                for (size_t w = 0; w < Signature::WORDS && bits; w++) {
+                    bits &= match_word(signature.words[w], include_table[w].data() + base, exclude_table[w].data() + base, n);
+                }
+                out[base / 64] = bits;
+            }
         }
 
-        void entity_destroyed(Entity entity) {
-            for (auto const& pair : systems) {
-                auto const& system = pair.second;
-                system->entities.erase(entity);
+        // Bit i set where word has every bit of include[i] and none of
+        // exclude[i], for i < n rounded up to 4; the tables are padded.
+        static uint64_t match_word(uint64_t word, uint64_t const* include, uint64_t const* exclude, size_t n) {
+            uint64_t bits = 0;
+            size_t i = 0;
+#if defined(__AVX2__)
+            __m256i s = _mm256_set1_epi64x(static_cast<long long>(word));
+            for (; i < n; i += 4) {
+                __m256i in = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(include + i));
+                __m256i ex = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(exclude + i));
+                __m256i miss = _mm256_or_si256(_mm256_andnot_si256(s, in), _mm256_and_si256(s, ex));
+                __m256i hit = _mm256_cmpeq_epi64(miss, _mm256_setzero_si256());
+                bits |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(hit))) << i;
+            }
+#elif defined(__SSE2__)
+            __m128i s = _mm_set1_epi64x(static_cast<long long>(word));
+            for (; i < n; i += 2) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<__m128i const*>(include + i));
+                __m128i ex = _mm_loadu_si128(reinterpret_cast<__m128i const*>(exclude + i));
+                __m128i miss = _mm_or_si128(_mm_andnot_si128(s, in), _mm_and_si128(s, ex));
+                // SSE2 has no 64-bit compare: a lane hits when both halves are zero.
+                __m128i zero = _mm_cmpeq_epi32(miss, _mm_setzero_si128());
+                __m128i hit = _mm_and_si128(zero, _mm_shuffle_epi32(zero, _MM_SHUFFLE(2, 3, 0, 1)));
+                bits |= uint64_t(_mm_movemask_pd(_mm_castsi128_pd(hit))) << i;
             }
+#endif
+            for (; i < n; i++) {
+                bits |= uint64_t(((~word & include[i]) | (word & exclude[i])) == 0) << i;
+            }
+            return bits;
+        }
+
+        // Only systems whose filter matched the dying entity's signature can
+        // hold it, so the rest are never touched.
+        void entity_destroyed(Entity entity, Signature entity_signature) {
+            match_systems(entity_signature, old_matches.data());
+            for_each_bit(old_matches.data(), [&](size_t i) { remove_from(i, entity); });
         }
 
-        void entity_signature_changed(Entity entity, Signature entity_signature) {
-            for (auto const& pair : systems) {
-                auto const& type = pair.first;
-                auto const& system = pair.second;
-                auto const& system_signature = signatures[type];
+        // System-major so each set stays hot while a batch is erased from it.
+        void entities_destroyed(Entity const* entities, Signature const* entity_signatures, size_t count) {
+            for (size_t i = 0; i < systems.size(); i++) {
+                for (size_t e = 0; e < count; e++) {
+                    if (entity_signatures[e].any() && entity_signatures[e].matches(include_masks[i], exclude_masks[i])) remove_from(i, entities[e]);
+                }
+            }
+        }
 
-                if ((entity_signature & system_signature) == system_signature) {
-                    system->entities.insert(entity);
+        // Only systems whose verdict flips between the two signatures are
+        // touched, so adding component types doesn't add set operations.
+        void entity_signature_changed(Entity entity, Signature old_signature, Signature new_signature) {
+            match_systems(old_signature, old_matches.data());
+            match_systems(new_signature, new_matches.data());
+            for (size_t w = 0; w < old_matches.size(); w++) {
+                old_matches[w] ^= new_matches[w];
+            }
+            for_each_bit(old_matches.data(), [&](size_t i) {
+                if (new_matches[i / 64] >> (i % 64) & 1) {
+                    add_to(i, entity);
                 } else {
-                    system->entities.erase(entity);
+                    remove_from(i, entity);
                 }
+            });
+        }
+
+        void add_to(size_t index, Entity entity) {
+            if (systems[index]->entities.insert(entity).second) systems[index]->entity_added(entity);
+        }
+
+        void remove_from(size_t index, Entity entity) {
+            if (systems[index]->entities.erase(entity)) systems[index]->entity_removed(entity);
+        }
+
+        template<typename F>
+        void for_each_bit(uint64_t const* bits, F&& f) {
+            for (size_t w = 0; w < old_matches.size(); w++) {
+                uint64_t word = bits[w];
+                while (word) {
+                    f(w * 64 + __builtin_ctzll(word));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        void memory_report(MemoryReport& report) {
+            // std::set nodes: three links, a color word and the key
+            size_t node_size = 3 * sizeof(void*) + sizeof(int) + sizeof(Entity);
+            report.system_count = systems.size();
+            report.system_bytes = systems.capacity() * sizeof(std::shared_ptr<System>)
+                + include_masks.capacity() * sizeof(Signature) * 3
+                + include_table[0].capacity() * sizeof(uint64_t) * 2 * Signature::WORDS
+                + resource_access.capacity() * sizeof(ResourceAccess);
+            for (auto const& system : systems) {
+                report.system_bytes += sizeof(System) + system->entities.size() * pooled_node_bytes(node_size);
             }
         }
 
-        std::unordered_map<const char*, Signature> signatures;
-        std::unordered_map<const char*, std::shared_ptr<System>> systems;
+        // Indexed by registration order.
+        std::vector<std::shared_ptr<System>> systems;
+        std::vector<Signature> include_masks;
+        std::vector<Signature> exclude_masks;
+        std::vector<Signature> optional_masks;
+        // The same filters word-major for match_systems: include_table[w][i]
+        // is word w of system i's include mask, padded to a multiple of 4.
+        std::array<std::vector<uint64_t>, Signature::WORDS> include_table;
+        std::array<std::vector<uint64_t>, Signature::WORDS> exclude_table;
+        std::vector<ResourceAccess> resource_access;
+        std::unordered_map<const char*, size_t> system_indices;
+        std::vector<uint64_t> old_matches; // scratch, one bit per system
+        std::vector<uint64_t> new_matches;
+        std::pmr::memory_resource* nodes;
 };
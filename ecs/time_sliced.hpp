@@ -0,0 +1,56 @@
+#pragma once
+#include "ecs.hpp"
+#include <chrono>
+
+// System that spreads one pass over its entities across as many frames as it
+// takes to stay inside budget_us per frame. The cursor is the last entity
+// processed, resumed with upper_bound, so it stays valid while entities join
+// and leave the set, between frames or from inside f (which may destroy the
+// entity it was given).
+//
+//   struct PlannerSystem : TimeSlicedSystem {
+//       PlannerSystem() : TimeSlicedSystem(500) {}
+//       void update() { update_sliced([&](Entity entity) { replan(entity); }); }
+//   };
+class TimeSlicedSystem : public System {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        TimeSlicedSystem(uint32_t budget_us = 1000) : budget_us(budget_us) {}
+
+        // Returns true when this call finished a pass.
+        template<typename F>
+        bool update_sliced(F&& f) {
+            auto deadline = Clock::now() + std::chrono::microseconds(budget_us);
+            auto it = cursor == NO_ENTITY ? entities.begin() : entities.upper_bound(cursor);
+            frames_in_pass++;
+
+            uint32_t processed = 0;
+            while (it != entities.end()) {
+                Entity entity = *it;
+                f(entity);
+                cursor = entity;
+                it = entities.upper_bound(entity); // f may have erased it
+                // Reading the clock per entity would cost more than cheap
+                // updates, so only look every check_interval entities.
+                if (++processed % check_interval == 0 && Clock::now() >= deadline) break;
+            }
+
+            if (it != entities.end()) return false;
+
+            frames_per_pass = frames_in_pass;
+            frames_in_pass = 0;
+            cursor = NO_ENTITY;
+            passes++;
+            return true;
+        }
+
+        uint32_t budget_us;
+        uint32_t check_interval = 16;
+        uint32_t frames_per_pass = 0; // frames the last full pass took
+        uint64_t passes = 0;
+
+    private:
+        Entity cursor = NO_ENTITY;
+        uint32_t frames_in_pass = 0;
+};
@@ -1,6 +1,10 @@
 #include "vulkan/vk_engine.hpp"
 #include "ecs/coordinator.hpp"
+#include "core/frame_loop.hpp"
+#include "core/jobs.hpp"
 #include <chrono>
+#include <cstring>
+#include <cstdlib>
 
 struct Gravity {
     glm::vec3 position;
@@ -12,16 +16,36 @@ struct PhysicsSystem : System {
     }
 };
 
-int main() {
+int main(int argc, char** argv) {
+    // --headless <ticks> runs the simulation flat out with no window or swapchain
+    // --record <file> journals structural changes and ticks of this session
+    // --replay <file> re-runs a journal headless and reports its throughput
+    // --pipelined simulates the next frame while the current one is drawn
+    const char* ticks_arg = nullptr;
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    bool pipelined = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pipelined") == 0) pipelined = true;
+        else if (i + 1 == argc) break;
+        else if (strcmp(argv[i], "--headless") == 0) ticks_arg = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0) record_path = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0) replay_path = argv[++i];
+    }
+    bool headless = ticks_arg || replay_path;
+
     VulkanEngine engine;
 
-    engine.init();
+    if (!headless) engine.init();
     
     std::cout << "Clown is running!" << std::endl;
+    // Big component arrays go in one huge-page backed arena to cut TLB
+    // misses when systems walk them; it has to outlive the coordinator.
+    HugePageArena component_memory (8 * HugePageArena::HUGE_PAGE_SIZE);
     Coordinator coordinator;
 
     coordinator.init(); // Initializes entity manager, system manager and component manager
-    coordinator.register_component<Gravity>();
+    coordinator.register_component<Gravity>(&component_memory);
 
     auto physics_system = coordinator.register_system<PhysicsSystem>();
 
@@ -30,6 +54,54 @@ int main() {
 
     coordinator.set_system_signature<PhysicsSystem>(signature); // Identify which components are going to be used in the system
 
+    // Systems run as jobs on the worker fibers; a tick is done when its
+    // counter drains. Rendering stays on the main thread.
+    JobSystem jobs;
+    JobProfile job_profile;
+
+    // Per-tick scratch; belongs to the simulation side, which never runs
+    // two ticks at once.
+    LinearAllocator frame_memory (1 << 20);
+
+    auto simulate = [&](float dt) {
+        if (coordinator.journal) coordinator.journal->tick(dt);
+        engine.begin_tick();
+        std::pmr::vector<Job> systems (&frame_memory);
+        systems.push_back(Job { [&] { physics_system->update(dt); }, "physics" });
+        JobCounter tick;
+        jobs.run(systems.data(), systems.size(), &tick);
+        jobs.wait(tick);
+    };
+
+    if (replay_path) {
+        JournalReader reader (replay_path);
+        if (!reader.valid) {
+            std::cerr << "Can't read journal " << replay_path << std::endl;
+            return 1;
+        }
+        auto start_time = std::chrono::high_resolution_clock::now();
+        uint64_t ticks = coordinator.replay(reader, [&](float dt) {
+            frame_memory.reset();
+            simulate(dt);
+        });
+        auto stop_time = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double, std::chrono::seconds::period>(stop_time - start_time).count();
+        if (reader.corrupt) std::cerr << "Journal " << replay_path << " has a bad record, stopped after " << ticks << " ticks" << std::endl;
+        std::cout << "replayed " << ticks << " ticks in " << seconds << "s (" << ticks / seconds << " ticks/s)" << std::endl;
+        std::cout << coordinator.memory_report().to_json() << std::endl;
+        return 0;
+    }
+
+    std::unique_ptr<Journal> journal;
+    if (record_path) {
+        journal = std::make_unique<Journal>(record_path);
+        if (!journal->is_open()) {
+            std::cerr << "Can't write journal " << record_path << std::endl;
+            return 1;
+        }
+        coordinator.journal = journal.get();
+    }
+
     std::vector<Entity> entities (MAX_ENTITIES);
 
     for (auto& entity : entities) {
@@ -37,16 +109,41 @@ int main() {
         coordinator.add_component(entity, Gravity { glm::vec3(0.0f, -9.81f, 0.0f) });
     }
 
-    float dt = 0.0f;
-    
-    bool quit = false;
-    while(!quit) {
-        auto start_time = std::chrono::high_resolution_clock::now();
-        physics_system->update(dt);
+    FrameLoop loop (60.0); // simulation tick rate, independent of present rate
+    loop.frame_allocator = &frame_memory;
 
-        engine.update();
+    if (headless) {
+        jobs.on_job_finished = [&](JobTiming const& timing) { job_profile.record(timing); };
+        uint64_t ticks = strtoull(ticks_arg, nullptr, 10);
+        auto start_time = std::chrono::high_resolution_clock::now();
+        loop.run_headless(ticks, simulate);
         auto stop_time = std::chrono::high_resolution_clock::now();
-        dt = std::chrono::duration<float, std::chrono::seconds::period>(stop_time - start_time).count();
+        double seconds = std::chrono::duration<double, std::chrono::seconds::period>(stop_time - start_time).count();
+        std::cout << ticks << " ticks in " << seconds << "s (" << ticks / seconds << " ticks/s)" << std::endl;
+        std::cout << coordinator.memory_report().to_json() << std::endl;
+        job_profile.write_json(std::cout);
+        std::cout << std::endl;
+        std::cout << "frame memory high water " << frame_memory.high_water << " bytes, " << frame_memory.overflow_count << " overflows" << std::endl;
+        return 0;
+    }
+
+    DoubleBuffered<RenderSnapshot> snapshots;
+    engine.extract(snapshots.back(), 1.0f);
+    snapshots.publish();
+
+    loop.start();
+    while(engine.window->window_should_run) {
+        if (pipelined) {
+            loop.frame(jobs, snapshots, simulate, [&](RenderSnapshot& snapshot, float alpha) {
+                engine.extract(snapshot, alpha);
+            }, [&](RenderSnapshot const& snapshot) {
+                engine.update(snapshot);
+            });
+            continue;
+        }
+        loop.frame(simulate, [&](float alpha) {
+            engine.update(alpha);
+        });
     }
 
     engine.cleanup();
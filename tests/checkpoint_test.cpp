@@ -0,0 +1,204 @@
+// Restoring a checkpoint puts back component values, living entities,
+// signatures, system membership and group sizes as they were, and what
+// happens after a restore can be rolled back again. A checkpoint only copies what was
+// written since the last one. Split, buffer and indexed components are
+// skipped and keep their current state across a restore.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+struct Position {
+    int x;
+};
+
+struct Velocity {
+    double v;
+};
+
+struct Tag {
+    int t;
+};
+
+struct Hot {
+    int h;
+};
+
+struct Cold {
+    int c;
+};
+
+struct Team {
+    int id;
+};
+
+using Inventory = DynamicBuffer<int, 2>;
+
+struct Movers : System {};
+
+struct Snapshot {
+    std::map<Entity, int> positions;
+    std::map<Entity, double> velocities;
+    std::map<Entity, int> tags;
+    std::vector<Signature> signatures;
+    std::vector<Entity> movers;
+    size_t group_size;
+    uint32_t living;
+
+    bool operator==(Snapshot const& other) const {
+        return positions == other.positions && velocities == other.velocities && tags == other.tags
+            && signatures == other.signatures && movers == other.movers
+            && group_size == other.group_size && living == other.living;
+    }
+};
+
+template<typename T>
+static bool has(Coordinator& world, Entity entity) {
+    return world.entity_manager->get_signature(entity).test(world.component_manager->get_component_type<T>());
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Position>();
+    world->register_component<Velocity>();
+    auto movers = world->register_system<Movers>();
+    world->set_system_filter<Movers>(With<Position, Velocity>());
+    auto group = world->group<Position, Velocity>();
+    world->enable_checkpoints(8);
+    // Registered late: picks up history at the current checkpoint.
+    world->register_component<Tag>();
+    std::mt19937 random (5);
+
+    std::vector<Entity> live;
+    auto snapshot = [&] {
+        Snapshot snapshot;
+        for (Entity entity : live) {
+            if (has<Position>(*world, entity)) snapshot.positions[entity] = world->read_component<Position>(entity).x;
+            if (has<Velocity>(*world, entity)) snapshot.velocities[entity] = world->read_component<Velocity>(entity).v;
+            if (has<Tag>(*world, entity)) snapshot.tags[entity] = world->read_component<Tag>(entity).t;
+        }
+        snapshot.signatures.assign(world->entity_manager->signatures.begin(), world->entity_manager->signatures.end());
+        snapshot.movers.assign(movers->entities.begin(), movers->entities.end());
+        snapshot.group_size = group->size;
+        snapshot.living = world->entity_manager->living_entity_count;
+        return snapshot;
+    };
+
+    std::map<uint64_t, Snapshot> snapshots;
+    std::map<uint64_t, std::vector<Entity>> lives;
+    int restores = 0;
+    for (int tick = 0; tick < 1500; tick++) {
+        for (uint32_t step = random() % 20; step > 0; step--) {
+            uint32_t op = random() % 10;
+            if (op == 9 && live.size() < 3000) {
+                Entity entity = world->create_entity();
+                world->add_component(entity, Position { static_cast<int>(random() % 100) });
+                if (random() % 2) world->add_component(entity, Velocity { static_cast<double>(random() % 7) });
+                live.push_back(entity);
+                continue;
+            }
+            if (live.empty()) continue;
+            Entity entity = live[random() % live.size()];
+            switch (op) {
+                case 0:
+                    if (has<Velocity>(*world, entity)) world->remove_component<Velocity>(entity);
+                    else world->add_component(entity, Velocity { 1.5 });
+                    break;
+                case 1:
+                    if (has<Tag>(*world, entity)) world->remove_component<Tag>(entity);
+                    else world->add_component(entity, Tag { 7 });
+                    break;
+                case 2:
+                    if (random() % 4 == 0) {
+                        world->destroy_entity(entity);
+                        live.erase(std::find(live.begin(), live.end(), entity));
+                    }
+                    break;
+                default:
+                    if (auto position = world->try_get_component<Position>(entity)) position->x += 3;
+                    if (auto velocity = world->try_get_component<Velocity>(entity)) velocity->v *= 1.01;
+                    break;
+            }
+        }
+        group->each([&](Entity, Position& position, Velocity&) {
+            if (random() % 50 == 0) position.x--;
+        });
+
+        uint64_t id = world->checkpoint();
+        snapshots[id] = snapshot();
+        lives[id] = live;
+        if (tick % 37 == 36) {
+            uint64_t target = id - random() % 8;
+            world->restore_checkpoint(target);
+            live = lives[target];
+            Snapshot restored = snapshot();
+            std::sort(restored.movers.begin(), restored.movers.end());
+            Snapshot& expected = snapshots[target];
+            std::sort(expected.movers.begin(), expected.movers.end());
+            assert(restored == expected && "Restore didn't give back the checkpointed world");
+            assert(group->size == restored.movers.size());
+
+            // Work done after a restore rolls back to the same checkpoint.
+            Entity entity = world->create_entity();
+            world->destroy_entity(entity);
+            world->restore_checkpoint(target);
+            assert(snapshot().signatures == expected.signatures);
+            restores++;
+        }
+    }
+    assert(restores > 30);
+
+    // Cost follows what was written. Fill the window with quiet checkpoints,
+    // then write one slot: one component page and no entity entries.
+    for (int i = 0; i < 8; i++) world->checkpoint();
+    auto positions = world->component_manager->get_component_array<Position>();
+    size_t quiet = positions->history->components.memory_usage();
+    assert(world->entity_history.frames.back().changes.empty());
+    for (Entity entity : live) world->read_component<Position>(entity);
+    world->checkpoint();
+    assert(positions->history->components.memory_usage() == quiet && "Reads were copied");
+    world->get_component<Position>(live[0]).x++;
+    world->checkpoint();
+    assert(positions->history->components.memory_usage() == quiet + sizeof(PagedHistory<Position>::Page));
+    assert(world->entity_history.frames.back().changes.empty());
+    Entity fresh = world->create_entity();
+    world->add_component(fresh, Tag { 1 });
+    world->checkpoint();
+    assert(world->entity_history.frames.back().changes.size() == 1 && "Entity history copied untouched entities");
+    world->destroy_entity(fresh);
+
+    // Kinds with state outside their slots get no history, and a restore
+    // leaves them as they are.
+    world->register_split_component<Hot, Cold>();
+    world->register_buffer<Inventory>();
+    world->register_component<Team>();
+    world->register_index<Team>([](Team const& team) { return team.id; });
+    assert(!world->component_manager->get_component_array<Hot>()->history);
+    assert(!world->component_manager->get_component_array<Inventory>()->history);
+    assert(!world->component_manager->get_component_array<Team>()->history);
+
+    Entity keeper = live[0];
+    world->add_component(keeper, Hot { 1 }, Cold { 2 });
+    world->add_component(keeper, Team { 1 });
+    BufferArena<int>& arena = world->buffer_arena<int>();
+    Inventory inventory;
+    for (int item = 0; item < 5; item++) inventory.push_back(item, arena);
+    world->add_component(keeper, std::move(inventory));
+    uint64_t before = world->checkpoint();
+    world->get_cold_component<Hot, Cold>(keeper).c = 3;
+    world->set_component(keeper, Team { 4 });
+    world->get_component<Inventory>(keeper).push_back(5, arena);
+    world->checkpoint();
+    world->restore_checkpoint(before);
+    assert((world->get_cold_component<Hot, Cold>(keeper).c == 3));
+    assert(world->read_component<Team>(keeper).id == 4);
+    assert(world->get_component<Inventory>(keeper).size == 6);
+
+    printf("checkpoint_test: ok\n");
+}
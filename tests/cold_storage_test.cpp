@@ -0,0 +1,88 @@
+// The cold half of a split component stays at the same dense index as its
+// hot half through swap-removes, sorts and migration into another world,
+// and costs nothing until slots reach it. The memory report counts its
+// pages as cold_bytes.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Unit {
+    float x;
+    int id;
+};
+
+struct UnitDebug {
+    std::string name;
+    int id;
+};
+
+static size_t cold_bytes(Coordinator& world) {
+    size_t total = 0;
+    for (auto const& component : world.memory_report().components) total += component.cold_bytes;
+    return total;
+}
+
+// Every hot slot's cold half belongs to the same unit.
+static void check(Coordinator& world) {
+    auto units = world.component_manager->get_component_array<Unit>();
+    for (size_t i = 0; i < units->size; i++) {
+        Entity entity = units->index_to_entity[i];
+        int id = units->component_array[i].id;
+        UnitDebug& debug = world.get_cold_component<Unit, UnitDebug>(entity);
+        assert(debug.id == id && debug.name == "unit" + std::to_string(id) && "Cold half drifted from its hot half");
+    }
+}
+
+static void make_world(Coordinator& world) {
+    world.init();
+    world.register_split_component<Unit, UnitDebug>();
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    make_world(*world);
+    assert(cold_bytes(*world) == 0 && "Cold pages allocated before any slot used them");
+
+    std::vector<Entity> entities;
+    for (int i = 0; i < 1200; i++) {
+        Entity entity = world->create_entity();
+        world->add_component(entity, Unit { static_cast<float>(i), i }, UnitDebug { "unit" + std::to_string(i), i });
+        entities.push_back(entity);
+    }
+    check(*world);
+    // 1200 slots span five 256-slot pages.
+    using Cold = ColdStorage<Unit, UnitDebug>;
+    assert(cold_bytes(*world) >= 5 * Cold::PAGE_SIZE * sizeof(UnitDebug));
+
+    // Swap-removes from the middle, both via remove and destroy.
+    for (int i = 0; i < 1200; i += 3) world->destroy_entity(entities[i]);
+    for (int i = 1; i < 1200; i += 9) world->remove_component<Unit>(entities[i]);
+    check(*world);
+
+    world->sort_components<Unit>([](Unit const& a, Unit const& b) { return a.x > b.x; });
+    check(*world);
+    world->radix_sort_components<Unit>([](Unit const& unit) { return static_cast<uint32_t>(unit.id % 17); });
+    check(*world);
+
+    // Adding only the hot half default-initializes the cold one.
+    Entity plain = world->create_entity();
+    world->add_component(plain, Unit { 0.0f, -1 });
+    assert((world->get_cold_component<Unit, UnitDebug>(plain).name.empty()));
+    world->destroy_entity(plain);
+
+    auto other = std::make_unique<Coordinator>();
+    make_world(*other);
+    std::vector<Entity> moving;
+    for (int i = 602; i < 900; i += 3) moving.push_back(entities[i]);
+    std::vector<Entity> moved = other->migrate_entities(*world, moving);
+    assert(moved.size() == moving.size());
+    assert(other->component_manager->get_component_array<Unit>()->size == moving.size());
+    check(*world);
+    check(*other);
+
+    printf("cold_storage_test: ok\n");
+}
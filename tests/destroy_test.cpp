@@ -0,0 +1,108 @@
+// Destruction is driven by the dying entities' signatures: only arrays
+// whose bit some entity has and only systems that held one are touched,
+// for single destroys and batches alike. What's left keeps its data and
+// memberships, and the ids go back to the free list.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+struct Projectile {
+    Entity owner;
+};
+
+struct Unit {
+    Entity owner;
+};
+
+// Registered but never added: destruction must not visit it at all.
+class ProbeArray final : public IComponentArray {
+    public:
+        void entity_destroyed(Entity) override { visits++; }
+        void remove(Entity) override { visits++; }
+        size_t count() override { return 0; }
+        Entity entity_at(size_t) override { return NO_ENTITY; }
+        bool contains(Entity) override { visits++; return false; }
+        size_t index_of(Entity) override { return 0; }
+        void swap_entries(size_t, size_t) override {}
+        ComponentMemory memory_usage() override { return ComponentMemory(); }
+        void migrate_to(IComponentArray&, Entity const*) override {}
+        uint32_t component_size() override { return 0; }
+
+        size_t visits = 0;
+};
+
+struct CountingSystem : System {
+    void entity_removed(Entity) override { removed++; }
+    size_t removed = 0;
+};
+
+struct Projectiles : CountingSystem {};
+struct Units : CountingSystem {};
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Projectile>();
+    world->register_component<Unit>();
+    auto probe = std::make_shared<ProbeArray>();
+    world->component_manager->add_array("probe", probe);
+
+    auto projectiles = world->register_system<Projectiles>();
+    world->set_system_filter<Projectiles>(With<Projectile>());
+    auto units = world->register_system<Units>();
+    world->set_system_filter<Units>(With<Unit>());
+
+    std::vector<Entity> shots;
+    std::vector<Entity> soldiers;
+    for (int i = 0; i < 1000; i++) {
+        Entity entity = world->create_entity();
+        world->add_component(entity, Projectile { entity });
+        shots.push_back(entity);
+    }
+    for (int i = 0; i < 100; i++) {
+        Entity entity = world->create_entity();
+        world->add_component(entity, Unit { entity });
+        soldiers.push_back(entity);
+    }
+
+    // Mass despawn of projectiles leaves units, their system and the probe alone.
+    std::vector<Entity> volley (shots.begin(), shots.begin() + 600);
+    world->destroy_entities(volley);
+    assert(projectiles->removed == 600 && projectiles->entities.size() == 400);
+    assert(units->removed == 0 && units->entities.size() == 100);
+    assert(probe->visits == 0 && "Batch destroy visited an array none of the entities had");
+
+    auto shot_array = world->component_manager->get_component_array<Projectile>();
+    assert(shot_array->size == 400);
+    for (size_t i = 0; i < shot_array->size; i++) {
+        Entity entity = shot_array->index_to_entity[i];
+        assert(shot_array->component_array[i].owner == entity && "Surviving component lost its data");
+    }
+    for (Entity entity : volley) {
+        assert(world->entity_manager->get_signature(entity).none() && !shot_array->contains(entity));
+    }
+    assert(world->entity_manager->living_entity_count == 500);
+
+    // Single destroys follow the same rule.
+    world->destroy_entity(soldiers[0]);
+    assert(units->removed == 1 && projectiles->removed == 600 && probe->visits == 0);
+
+    // A batch mixing both kinds, and entities with no components at all.
+    std::vector<Entity> mixed (shots.begin() + 600, shots.end());
+    mixed.insert(mixed.end(), soldiers.begin() + 1, soldiers.end());
+    for (int i = 0; i < 10; i++) mixed.push_back(world->create_entity());
+    world->destroy_entities(mixed);
+    assert(projectiles->entities.empty() && units->entities.empty());
+    assert(world->component_manager->get_component_array<Unit>()->size == 0 && shot_array->size == 0);
+    assert(probe->visits == 0);
+    assert(world->entity_manager->living_entity_count == 0);
+
+    // Every id is free again.
+    std::vector<Entity> all (MAX_ENTITIES);
+    world->entity_manager->create_entities(all.data(), MAX_ENTITIES);
+
+    printf("destroy_test: ok\n");
+}
@@ -0,0 +1,53 @@
+// Spilled DynamicBuffers must hand their arena block to the component on
+// insert, leaving the buffer they were moved from empty, and give it back
+// on destroy and migration, so BufferArena::live tracks exactly what live
+// entities hold.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using Buffer = DynamicBuffer<int, 2>;
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_buffer<Buffer>();
+    BufferArena<int>& arena = world->buffer_arena<int>();
+
+    std::vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        Buffer buffer;
+        for (int j = 0; j < 8; j++) buffer.push_back(i * 8 + j, arena);
+        Entity entity = world->create_entity();
+        world->add_component(entity, std::move(buffer));
+        assert(!buffer.spilled() && buffer.size == 0 && "Moved-from buffer still points at the component's block");
+        entities.push_back(entity);
+    }
+    assert(arena.live == 800 && "Adding a spilled buffer kept the caller's block alive");
+
+    for (int i = 0; i < 100; i++) {
+        Buffer& buffer = world->get_component<Buffer>(entities[i]);
+        for (int j = 0; j < 8; j++) assert(buffer[j] == i * 8 + j);
+    }
+
+    // Half go to another world: their blocks move arenas.
+    auto other = std::make_unique<Coordinator>();
+    other->init();
+    other->register_buffer<Buffer>();
+    std::vector<Entity> half (entities.begin(), entities.begin() + 50);
+    std::vector<Entity> moved = other->migrate_entities(*world, half);
+    assert(arena.live == 400 && other->buffer_arena<int>().live == 400);
+    for (int i = 0; i < 50; i++) {
+        Buffer& buffer = other->get_component<Buffer>(moved[i]);
+        for (int j = 0; j < 8; j++) assert(buffer[j] == i * 8 + j);
+    }
+
+    world->destroy_entities(std::vector<Entity>(entities.begin() + 50, entities.end()));
+    other->destroy_entities(moved);
+    assert(arena.live == 0 && other->buffer_arena<int>().live == 0);
+
+    printf("dynamic_buffer_test: ok\n");
+}
@@ -0,0 +1,116 @@
+// An owning group keeps the first size slots of every owned array holding
+// the same entities in the same order, whatever order components are added
+// and removed in, across destroys and migration into another world.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+struct Transform {
+    Entity owner;
+};
+
+struct Velocity {
+    Entity owner;
+};
+
+struct Tag {};
+
+using Motion = Group<Transform, Velocity>;
+
+static void check(Coordinator& world, Motion& group) {
+    auto transforms = world.component_manager->get_component_array<Transform>();
+    auto velocities = world.component_manager->get_component_array<Velocity>();
+    size_t members = 0;
+    for (size_t i = 0; i < transforms->size; i++) {
+        if (velocities->contains(transforms->index_to_entity[i])) members++;
+    }
+    assert(group.size == members && "Group size doesn't match the entities holding every owned component");
+    for (size_t i = 0; i < group.size; i++) {
+        Entity entity = transforms->index_to_entity[i];
+        assert(velocities->index_to_entity[i] == entity && "Owned arrays out of step");
+        assert(transforms->component_array[i].owner == entity && velocities->component_array[i].owner == entity);
+    }
+
+    size_t visited = 0;
+    group.each([&](Entity entity, Transform& transform, Velocity& velocity) {
+        assert(transform.owner == entity && velocity.owner == entity);
+        visited++;
+    });
+    assert(visited == group.size);
+}
+
+static void make_world(Coordinator& world) {
+    world.init();
+    world.register_component<Transform>();
+    world.register_component<Velocity>();
+    world.register_component<Tag>();
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    make_world(*world);
+    std::mt19937 random (11);
+
+    // Entities that exist before the group is declared are picked up.
+    std::vector<Entity> entities;
+    for (int i = 0; i < 200; i++) {
+        Entity entity = world->create_entity();
+        if (i % 2) world->add_component(entity, Transform { entity });
+        if (i % 3) world->add_component(entity, Velocity { entity });
+        entities.push_back(entity);
+    }
+    auto group = world->group<Transform, Velocity>();
+    check(*world, *group);
+
+    for (int round = 0; round < 5000; round++) {
+        Entity& entity = entities[random() % entities.size()];
+        switch (random() % 6) {
+            case 0:
+                if (!world->try_get_component<Transform>(entity)) world->add_component(entity, Transform { entity });
+                break;
+            case 1:
+                if (!world->try_get_component<Velocity>(entity)) world->add_component(entity, Velocity { entity });
+                break;
+            case 2:
+                if (world->try_get_component<Transform>(entity)) world->remove_component<Transform>(entity);
+                break;
+            case 3:
+                if (world->try_get_component<Velocity>(entity)) world->remove_component<Velocity>(entity);
+                break;
+            case 4:
+                // Components outside the group don't move anyone.
+                if (!world->try_get_component<Tag>(entity)) world->add_component(entity, Tag {});
+                break;
+            case 5:
+                world->destroy_entity(entity);
+                entity = world->create_entity();
+                break;
+        }
+        if (round % 100 == 0) check(*world, *group);
+    }
+    check(*world, *group);
+
+    std::vector<Entity> doomed (entities.begin(), entities.begin() + 50);
+    world->destroy_entities(doomed);
+    check(*world, *group);
+
+    // Migrated members join the destination's group; the source's closes up.
+    auto other = std::make_unique<Coordinator>();
+    make_world(*other);
+    auto other_group = other->group<Transform, Velocity>();
+    std::vector<Entity> half (entities.begin() + 50, entities.begin() + 125);
+    std::vector<Entity> moved = other->migrate_entities(*world, half);
+    check(*world, *group);
+    // Owner fields still name the source ids; re-stamp them to compare.
+    for (Entity entity : moved) {
+        if (auto transform = other->try_get_component<Transform>(entity)) transform->owner = entity;
+        if (auto velocity = other->try_get_component<Velocity>(entity)) velocity->owner = entity;
+    }
+    check(*other, *other_group);
+
+    printf("group_test: ok\n");
+}
@@ -0,0 +1,145 @@
+// Secondary indexes on a component stay in step with the array through
+// every write they're told about: adds, set_component, patch_component,
+// in-place writes reported with mark_changed, removes, destroys and
+// migration into a world indexing the same component. Entities that existed
+// before the index was registered are picked up. Mutable access to an
+// indexed component aborts in debug builds.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+struct Team {
+    int id;
+    float health;
+};
+
+static int team_of(Team const& team) {
+    return team.id;
+}
+
+static float health_of(Team const& team) {
+    return team.health;
+}
+
+using ByTeam = HashIndex<Team, int>;
+using ByHealth = SortedIndex<Team, float>;
+
+// Every index answer matches a scan of the array.
+static void check(Coordinator& world, ByTeam& by_team, ByHealth& by_health) {
+    auto teams = world.component_manager->get_component_array<Team>();
+    for (int id = 0; id < 5; id++) {
+        size_t expected = 0;
+        for (size_t i = 0; i < teams->size; i++) {
+            if (teams->component_array[i].id == id) expected++;
+        }
+        assert(by_team.find(id).size() == expected && "Hash index out of step");
+        for (Entity entity : by_team.find(id)) assert(world.read_component<Team>(entity).id == id);
+    }
+
+    size_t expected = 0;
+    for (size_t i = 0; i < teams->size; i++) {
+        float health = teams->component_array[i].health;
+        if (health >= 10.0f && health <= 50.0f) expected++;
+    }
+    size_t found = 0;
+    float previous = 10.0f;
+    by_health.for_range(10.0f, 50.0f, [&](Entity entity) {
+        float health = world.read_component<Team>(entity).health;
+        assert(health >= previous && health <= 50.0f && "Sorted index range out of order or bounds");
+        previous = health;
+        found++;
+    });
+    assert(found == expected && "Sorted index out of step");
+}
+
+// True if f aborts on an assert in a child process.
+template<typename F>
+static bool aborts(F f) {
+    pid_t child = fork();
+    if (child == 0) {
+        freopen("/dev/null", "w", stderr);
+        f();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Team>();
+    std::mt19937 random (5);
+    std::uniform_real_distribution<float> health (0.0f, 100.0f);
+
+    std::vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        Entity entity = world->create_entity();
+        world->add_component(entity, Team { i % 4, health(random) });
+        entities.push_back(entity);
+    }
+    auto by_team = world->register_index<Team>(team_of);
+    auto by_health = world->register_sorted_index<Team>(health_of);
+    check(*world, *by_team, *by_health);
+
+    for (int round = 0; round < 3000; round++) {
+        Entity& entity = entities[random() % entities.size()];
+        bool has = world->try_read_component<Team>(entity) != nullptr;
+        switch (random() % 6) {
+            case 0:
+                if (!has) world->add_component(entity, Team { static_cast<int>(random() % 5), health(random) });
+                break;
+            case 1:
+                if (has) world->set_component(entity, Team { static_cast<int>(random() % 5), health(random) });
+                break;
+            case 2:
+                if (has) world->patch_component<Team>(entity, [&](Team& team) { team.health = health(random); });
+                break;
+            case 3:
+                // Written behind the index's back, then reported.
+                if (has) {
+                    auto teams = world->component_manager->get_component_array<Team>();
+                    teams->component_array[teams->index_of(entity)].id = static_cast<int>(random() % 5);
+                    world->mark_changed<Team>(entity);
+                }
+                break;
+            case 4:
+                if (has) world->remove_component<Team>(entity);
+                break;
+            case 5:
+                world->destroy_entity(entity);
+                entity = world->create_entity();
+                break;
+        }
+        if (round % 100 == 0) check(*world, *by_team, *by_health);
+    }
+    check(*world, *by_team, *by_health);
+
+    // Migrated entities leave the source's indexes and join the destination's.
+    auto other = std::make_unique<Coordinator>();
+    other->init();
+    other->register_component<Team>();
+    auto other_by_team = other->register_index<Team>(team_of);
+    auto other_by_health = other->register_sorted_index<Team>(health_of);
+    std::vector<Entity> half (entities.begin(), entities.begin() + 50);
+    other->migrate_entities(*world, half);
+    check(*world, *by_team, *by_health);
+    check(*other, *other_by_team, *other_by_health);
+
+    // Unindexed reads stay allowed; mutable access to an indexed one doesn't.
+    Entity sample = world->create_entity();
+    world->add_component(sample, Team { 1, 1.0f });
+    assert(world->read_component<Team>(sample).id == 1);
+    assert(aborts([&] { world->get_component<Team>(sample).id = 2; }));
+    assert(aborts([&] { world->try_get_component<Team>(sample); }));
+
+    printf("index_test: ok\n");
+}
@@ -0,0 +1,132 @@
+// Journals reach the file on flush(), replay stops cleanly at truncated or
+// out-of-range records instead of indexing past its tables, and components
+// whose bytes hold pointers fail the journal instead of being recorded.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+struct Health {
+    int value;
+};
+
+using Path = DynamicBuffer<int, 2>;
+
+static const char* PATH = "tests/journal_test.bin";
+
+static std::vector<uint8_t> read_file() {
+    std::vector<uint8_t> contents;
+    FILE* file = fopen(PATH, "rb");
+    assert(file);
+    int c;
+    while ((c = fgetc(file)) != EOF) contents.push_back(static_cast<uint8_t>(c));
+    fclose(file);
+    return contents;
+}
+
+static void write_file(std::vector<uint8_t> const& contents) {
+    FILE* file = fopen(PATH, "wb");
+    assert(file);
+    fwrite(contents.data(), 1, contents.size(), file);
+    fclose(file);
+}
+
+static uint64_t replay(bool& corrupt, size_t& count) {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Health>();
+    JournalReader reader (PATH);
+    assert(reader.valid);
+    uint64_t ticks = world->replay(reader, [](float) {});
+    corrupt = reader.corrupt;
+    count = world->component_manager->get_component_array<Health>()->size;
+    return ticks;
+}
+
+int main() {
+    {
+        auto world = std::make_unique<Coordinator>();
+        world->init();
+        world->register_component<Health>();
+        Journal journal (PATH);
+        assert(journal.is_open());
+        world->journal = &journal;
+        for (int tick = 0; tick < 10; tick++) {
+            for (int i = 0; i < 10; i++) world->add_component(world->create_entity(), Health { i });
+            journal.tick(1.0f / 60.0f);
+        }
+        journal.flush();
+        assert(read_file().size() == journal.bytes && "flush left bytes in the stdio buffer");
+        world->journal = nullptr;
+    }
+
+    bool corrupt;
+    size_t count;
+    assert(replay(corrupt, count) == 10 && !corrupt && count == 100);
+
+    std::vector<uint8_t> good = read_file();
+
+    // Cut mid-record.
+    write_file(std::vector<uint8_t>(good.begin(), good.end() - 3));
+    uint64_t ticks = replay(corrupt, count);
+    assert(ticks == 9 && corrupt);
+
+    // First CREATE after the header and the TYPE record names an entity
+    // far past MAX_ENTITIES.
+    std::vector<uint8_t> bad = good;
+    size_t create = 8;
+    while (bad[create] != static_cast<uint8_t>(JournalOp::CREATE)) create++;
+    Entity huge = 0xFFFFFFF0;
+    memcpy(&bad[create + 1], &huge, sizeof(huge));
+    write_file(bad);
+    assert(replay(corrupt, count) == 0 && corrupt && count == 0);
+
+    // An ADD for an entity that was never created.
+    bad = good;
+    Entity unknown = MAX_ENTITIES - 1;
+    memcpy(&bad[create + 1], &unknown, sizeof(unknown));
+    write_file(bad);
+    assert(replay(corrupt, count) == 0 && corrupt);
+
+    // A world that never registered the journal's component type.
+    write_file(good);
+    {
+        auto world = std::make_unique<Coordinator>();
+        world->init();
+        JournalReader reader (PATH);
+        assert(world->replay(reader, [](float) {}) == 0 && reader.corrupt);
+    }
+
+    // A buffer's bytes point into this process's arena: the journal stops
+    // at the first one and keeps the ticks before it.
+    {
+        auto world = std::make_unique<Coordinator>();
+        world->init();
+        world->register_component<Health>();
+        world->register_buffer<Path>();
+        Journal journal (PATH);
+        world->journal = &journal;
+        world->add_component(world->create_entity(), Health { 1 });
+        journal.tick(1.0f / 60.0f);
+
+        Path path;
+        for (int i = 0; i < 8; i++) path.push_back(i, world->buffer_arena<int>());
+        Entity entity = world->create_entity();
+        uint64_t bytes = journal.bytes;
+        world->add_component(entity, std::move(path));
+        assert(!journal.error.empty() && "Buffer component was journaled");
+        assert(journal.bytes == bytes);
+        world->add_component(world->create_entity(), Health { 2 });
+        journal.tick(1.0f / 60.0f);
+        assert(journal.bytes == bytes && "Journal kept recording after failing");
+        journal.flush();
+        world->journal = nullptr;
+    }
+    assert(replay(corrupt, count) == 1 && !corrupt && count == 1);
+
+    remove(PATH);
+    printf("journal_test: ok\n");
+}
@@ -0,0 +1,113 @@
+// A cached query returns the same entities as a scan of every live entity,
+// whether it was made before the world filled up (kept current by
+// signature changes) or after (built by one scan), through adds, removes,
+// single and batch destroys. Asking again returns the same cached list;
+// releasing drops it and the next ask rebuilds it.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+struct Position {
+    float x;
+};
+
+struct Health {
+    int hp;
+};
+
+struct Dead {};
+
+template<typename T>
+static bool has(Coordinator& world, Entity entity) {
+    return world.entity_manager->get_signature(entity).test(world.component_manager->get_component_type<T>());
+}
+
+template<typename Match>
+static void check(std::vector<Entity> const& cached, std::vector<Entity> const& live, Match match) {
+    std::vector<Entity> expected;
+    for (Entity entity : live) {
+        if (match(entity)) expected.push_back(entity);
+    }
+    std::vector<Entity> got = cached;
+    std::sort(got.begin(), got.end());
+    std::sort(expected.begin(), expected.end());
+    assert(got == expected && "Cached query differs from a scan");
+}
+
+template<typename T>
+static void toggle(Coordinator& world, Entity entity) {
+    if (has<T>(world, entity)) world.remove_component<T>(entity);
+    else world.add_component(entity, T {});
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Position>();
+    world->register_component<Health>();
+    world->register_component<Dead>();
+    std::mt19937 random (3);
+
+    auto alive = [&](Entity entity) { return has<Position>(*world, entity) && has<Health>(*world, entity) && !has<Dead>(*world, entity); };
+    auto positioned = [&](Entity entity) { return has<Position>(*world, entity); };
+
+    // Made on an empty world: everything it holds comes from events.
+    auto const& early = world->query(With<Position, Health>(), Without<Dead>());
+    assert(early.empty());
+
+    std::vector<Entity> live;
+    for (int round = 0; round < 20000; round++) {
+        uint32_t op = random() % 10;
+        if (op >= 6 || live.empty()) {
+            if (live.size() < 4000) live.push_back(world->create_entity());
+            continue;
+        }
+        Entity entity = live[random() % live.size()];
+        switch (op) {
+            case 1: toggle<Position>(*world, entity); break;
+            case 2: toggle<Health>(*world, entity); break;
+            case 3: toggle<Dead>(*world, entity); break;
+            case 4:
+                world->destroy_entity(entity);
+                live.erase(std::find(live.begin(), live.end(), entity));
+                break;
+            case 5: {
+                std::vector<Entity> batch;
+                for (int i = 0; i < 3 && !live.empty(); i++) {
+                    batch.push_back(live.back());
+                    live.pop_back();
+                }
+                world->destroy_entities(batch);
+                break;
+            }
+        }
+        if (round % 1000 == 0) check(early, live, alive);
+    }
+    check(early, live, alive);
+
+    // Made on a full world: one scan, then the same list on every ask.
+    auto const& late = world->query(With<Position>());
+    check(late, live, positioned);
+    assert(&world->query(With<Position>()) == &late && "Repeated query wasn't served from the cache");
+    assert(&world->query(With<Position, Health>(), Without<Dead>()) == &early);
+
+    for (int i = 0; i < 500; i++) toggle<Position>(*world, live[random() % live.size()]);
+    check(late, live, positioned);
+    check(early, live, alive);
+
+    // Released queries stop being tracked and come back rebuilt.
+    Signature position;
+    position.set(world->component_manager->get_component_type<Position>(), true);
+    world->release_query(position);
+    assert(world->query_cache->queries.size() == 1);
+    for (int i = 0; i < 500; i++) toggle<Position>(*world, live[random() % live.size()]);
+    check(world->query(With<Position>()), live, positioned);
+    check(early, live, alive);
+
+    printf("query_cache_test: ok\n");
+}
@@ -0,0 +1,101 @@
+// Relations index both directions, so children of a parent and targets of a
+// source are read straight from the lists. An exclusive relation replaces
+// the old target, and destroying a target of a cascading relation destroys
+// its sources, recursively, in one batch that also drops every pair the
+// dead entities took part in.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+struct Body {
+    Entity owner;
+};
+
+struct ChildOf {};
+struct Targets {};
+
+struct Bodies : System {
+    void entity_removed(Entity) override { removed++; }
+    size_t removed = 0;
+};
+
+static bool holds(std::vector<Entity> const& values, Entity value) {
+    return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Body>();
+    world->register_relation<ChildOf>(true, true);
+    world->register_relation<Targets>();
+    auto bodies = world->register_system<Bodies>();
+    world->set_system_filter<Bodies>(With<Body>());
+
+    // root -> 10 children -> 3 grandchildren each.
+    Entity root = world->create_entity();
+    world->add_component(root, Body { root });
+    std::vector<Entity> children;
+    std::vector<Entity> grandchildren;
+    for (int i = 0; i < 10; i++) {
+        Entity child = world->create_entity();
+        world->add_component(child, Body { child });
+        world->add_relation<ChildOf>(child, root);
+        children.push_back(child);
+        for (int j = 0; j < 3; j++) {
+            Entity grandchild = world->create_entity();
+            world->add_relation<ChildOf>(grandchild, child);
+            grandchildren.push_back(grandchild);
+        }
+    }
+    assert(world->related<ChildOf>(root).size() == 10);
+    for (Entity child : children) {
+        assert(world->relation_targets<ChildOf>(child).size() == 1 && world->relation_targets<ChildOf>(child)[0] == root);
+        assert(world->related<ChildOf>(child).size() == 3);
+    }
+
+    // Non-exclusive: many targets, duplicates ignored.
+    Entity hunter = world->create_entity();
+    world->add_relation<Targets>(hunter, children[0]);
+    world->add_relation<Targets>(hunter, root);
+    world->add_relation<Targets>(hunter, root);
+    assert(world->relation_targets<Targets>(hunter).size() == 2);
+    world->remove_relation<Targets>(hunter, children[0]);
+    assert(!world->has_relation<Targets>(hunter, children[0]) && world->has_relation<Targets>(hunter, root));
+    world->add_relation<Targets>(hunter, children[2]);
+
+    // Exclusive: reparenting drops the old parent from both sides.
+    Entity other = world->create_entity();
+    world->add_relation<ChildOf>(children[1], other);
+    assert(world->relation_targets<ChildOf>(children[1]).size() == 1 && world->has_relation<ChildOf>(children[1], other));
+    assert(world->related<ChildOf>(root).size() == 9 && !holds(world->related<ChildOf>(root), children[1]));
+
+    // Destroying root takes 9 children and their 27 grandchildren with it;
+    // the reparented child and its own grandchildren survive.
+    uint32_t living = world->entity_manager->living_entity_count;
+    world->destroy_entity(root);
+    assert(world->entity_manager->living_entity_count == living - 1 - 9 - 27);
+    assert(bodies->removed == 10 && bodies->entities.size() == 1 && bodies->entities.count(children[1]));
+    assert(world->component_manager->get_component_array<Body>()->size == 1);
+    assert(world->related<ChildOf>(other).size() == 1 && world->related<ChildOf>(children[1]).size() == 3);
+
+    // The hunter outlives its targets, but its pairs with them are gone.
+    assert(world->relation_targets<Targets>(hunter).empty());
+    assert(world->related<Targets>(root).empty() && world->related<Targets>(children[2]).empty());
+    for (Entity child : children) {
+        if (child == children[1]) continue;
+        assert(world->relation_targets<ChildOf>(child).empty() && world->related<ChildOf>(child).empty());
+    }
+
+    // A batch whose members are also each other's descendants destroys each once.
+    std::vector<Entity> batch = { other, children[1], grandchildren[3] };
+    world->destroy_entities(batch);
+    assert(world->entity_manager->living_entity_count == 1 && "Only the hunter should be left");
+    assert(bodies->entities.empty() && bodies->removed == 11);
+
+    printf("relation_test: ok\n");
+}
@@ -0,0 +1,121 @@
+// Shared components store each distinct value once, keep a member list per
+// value, and recycle a value once its last member leaves. Changing an
+// entity's value moves it between lists without touching its signature;
+// adding and removing drive system membership through Shared<T>.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+struct Material {
+    int shader;
+};
+
+struct Renderer : System {};
+
+static Material materials[4] = { { 0 }, { 1 }, { 2 }, { 3 } };
+
+// Member lists hold exactly the entities whose value is theirs.
+static void check(Coordinator& world, std::vector<Material*> const& expected) {
+    auto array = world.component_manager->get_shared_array<Material*>();
+    size_t members = 0;
+    size_t distinct = 0;
+    world.for_each_group<Material*>([&](Material* const& value, std::vector<Entity> const& entities) {
+        distinct++;
+        for (Entity entity : entities) {
+            assert(expected[entity] == value && world.get_shared_component<Material*>(entity) == value && "Entity in the wrong value's list");
+        }
+        members += entities.size();
+    });
+    size_t holding = 0;
+    std::vector<bool> used (4, false);
+    for (Entity entity = 0; entity < expected.size(); entity++) {
+        if (!expected[entity]) continue;
+        holding++;
+        used[expected[entity] - materials] = true;
+    }
+    size_t used_count = 0;
+    for (bool u : used) used_count += u;
+    assert(members == holding && array->count() == holding);
+    assert(distinct == used_count && array->distinct_count() == used_count && "A value is stored more than once or leaked");
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_shared_component<Material*>();
+    auto renderer = world->register_system<Renderer>();
+    world->set_system_filter<Renderer>(With<Shared<Material*>>());
+    std::mt19937 random (3);
+
+    std::vector<Entity> entities;
+    std::vector<Material*> expected (MAX_ENTITIES, nullptr);
+    for (int i = 0; i < 300; i++) {
+        Entity entity = world->create_entity();
+        if (i % 5) {
+            world->add_shared_component<Material*>(entity, &materials[i % 3]);
+            expected[entity] = &materials[i % 3];
+        }
+        entities.push_back(entity);
+    }
+    check(*world, expected);
+    assert(world->component_manager->get_shared_array<Material*>()->values.size() == 3);
+    assert(renderer->entities.size() == 240);
+
+    for (int round = 0; round < 3000; round++) {
+        Entity& entity = entities[random() % entities.size()];
+        Material* value = &materials[random() % 4];
+        switch (random() % 4) {
+            case 0:
+                if (!expected[entity]) {
+                    world->add_shared_component<Material*>(entity, value);
+                    expected[entity] = value;
+                }
+                break;
+            case 1:
+                if (expected[entity]) {
+                    Signature before = world->entity_manager->get_signature(entity);
+                    world->set_shared_component<Material*>(entity, value);
+                    expected[entity] = value;
+                    assert(world->entity_manager->get_signature(entity) == before);
+                }
+                break;
+            case 2:
+                if (expected[entity]) {
+                    world->remove_shared_component<Material*>(entity);
+                    expected[entity] = nullptr;
+                }
+                break;
+            case 3:
+                world->destroy_entity(entity);
+                expected[entity] = nullptr;
+                entity = world->create_entity();
+                break;
+        }
+        if (round % 100 == 0) check(*world, expected);
+    }
+    check(*world, expected);
+    size_t holding = 0;
+    for (Entity entity : entities) holding += expected[entity] != nullptr;
+    assert(renderer->entities.size() == holding);
+
+    // Moving everyone onto one value frees the others; they're reused, not grown.
+    for (Entity entity : entities) {
+        if (!expected[entity]) continue;
+        world->set_shared_component<Material*>(entity, &materials[0]);
+        expected[entity] = &materials[0];
+    }
+    check(*world, expected);
+    auto array = world->component_manager->get_shared_array<Material*>();
+    size_t slots = array->values.size();
+    Entity entity = world->create_entity();
+    world->add_shared_component<Material*>(entity, &materials[2]);
+    expected[entity] = &materials[2];
+    check(*world, expected);
+    assert(array->values.size() == slots && "Freed value id wasn't recycled");
+
+    printf("shared_component_test: ok\n");
+}
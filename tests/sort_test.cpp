@@ -0,0 +1,159 @@
+// Component storage sorts: the full and radix sorts order an array in place,
+// respect() lines a dependent up behind it, and IncrementalSort gets there
+// within its swap budget while entities come and go. None of them may touch
+// an array a group owns, including a dependent, or an array grouped after
+// the incremental sort was set up.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <random>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+struct Depth {
+    float z;
+};
+
+struct Mesh {
+    uint32_t id;
+};
+
+static bool by_depth(Depth const& a, Depth const& b) {
+    return a.z < b.z;
+}
+
+static void check_sorted(Coordinator& world) {
+    auto depths = world.component_manager->get_component_array<Depth>();
+    for (size_t i = 0; i < depths->size; i++) {
+        assert(depths->index_of(depths->index_to_entity[i]) == i && "Sort broke the entity to slot map");
+        if (i > 0) assert(!by_depth(depths->component_array[i], depths->component_array[i - 1]) && "Array not sorted");
+    }
+}
+
+// Every entity with both components sits at the same slot in Mesh as in Depth.
+static void check_aligned(Coordinator& world) {
+    auto depths = world.component_manager->get_component_array<Depth>();
+    auto meshes = world.component_manager->get_component_array<Mesh>();
+    size_t next = 0;
+    for (size_t i = 0; i < depths->size; i++) {
+        Entity entity = depths->index_to_entity[i];
+        if (!meshes->contains(entity)) continue;
+        assert(meshes->index_of(entity) == next++ && "Dependent not in the sorted array's order");
+        assert(meshes->component_array[meshes->index_of(entity)].id == entity && "Dependent slot lost its component");
+    }
+}
+
+static std::vector<Entity> populate(Coordinator& world, std::mt19937& random, int count) {
+    std::uniform_real_distribution<float> z (-100.0f, 100.0f);
+    std::vector<Entity> entities;
+    for (int i = 0; i < count; i++) {
+        Entity entity = world.create_entity();
+        world.add_component(entity, Depth { z(random) });
+        if (i % 3) world.add_component(entity, Mesh { entity });
+        entities.push_back(entity);
+    }
+    return entities;
+}
+
+static void make_world(Coordinator& world) {
+    world.init();
+    world.register_component<Depth>();
+    world.register_component<Mesh>();
+}
+
+// True if f aborts on an assert in a child process.
+template<typename F>
+static bool aborts(F f) {
+    pid_t child = fork();
+    if (child == 0) {
+        freopen("/dev/null", "w", stderr);
+        f();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+int main() {
+    std::mt19937 random (7);
+
+    {
+        Coordinator world;
+        make_world(world);
+        populate(world, random, 1000);
+        world.sort_components<Depth>(by_depth);
+        check_sorted(world);
+        world.respect<Mesh, Depth>();
+        check_aligned(world);
+
+        // Radix sort by a key that reverses id order.
+        world.radix_sort_components<Mesh>([](Mesh const& mesh) { return UINT32_MAX - mesh.id; });
+        auto meshes = world.component_manager->get_component_array<Mesh>();
+        for (size_t i = 1; i < meshes->size; i++) assert(meshes->component_array[i].id < meshes->component_array[i - 1].id);
+    }
+
+    {
+        Coordinator world;
+        make_world(world);
+        std::vector<Entity> entities = populate(world, random, 1000);
+        auto sorter = world.incremental_sort<Depth, Mesh>(by_depth);
+
+        // Churn a few entities a frame with a small budget: no step goes
+        // over it.
+        std::uniform_real_distribution<float> z (-100.0f, 100.0f);
+        for (int frame = 0; frame < 500; frame++) {
+            for (int i = 0; i < 4; i++) {
+                Entity& entity = entities[random() % entities.size()];
+                world.destroy_entity(entity);
+                entity = world.create_entity();
+                world.add_component(entity, Depth { z(random) });
+                if (frame % 2) world.add_component(entity, Mesh { entity });
+            }
+            assert(sorter->step(64) <= 64 && "Step went over its swap budget");
+        }
+
+        // Once entities stop changing, two full passes leave both arrays in order.
+        size_t passes = sorter->passes;
+        while (sorter->passes < passes + 2) sorter->step(64);
+        check_sorted(world);
+        check_aligned(world);
+    }
+
+    // Groups own the order of their arrays, so every sort refuses them.
+    auto grouped_world = [](Coordinator& world) {
+        make_world(world);
+        std::mt19937 random (1);
+        populate(world, random, 100);
+        world.group<Depth, Mesh>();
+    };
+    assert(aborts([&] { Coordinator world; grouped_world(world); world.sort_components<Depth>(by_depth); }));
+    assert(aborts([&] { Coordinator world; grouped_world(world); world.respect<Mesh, Depth>(); }));
+    assert(aborts([&] { Coordinator world; grouped_world(world); world.incremental_sort<Depth>(by_depth); }));
+
+    // Only the dependent is grouped.
+    assert(aborts([&] {
+        Coordinator world;
+        make_world(world);
+        world.register_component<float>();
+        world.group<Mesh, float>();
+        world.incremental_sort<Depth, Mesh>(by_depth);
+    }));
+
+    // The group comes after the sorter.
+    assert(aborts([&] {
+        Coordinator world;
+        make_world(world);
+        std::mt19937 random (2);
+        populate(world, random, 100);
+        auto sorter = world.incremental_sort<Depth, Mesh>(by_depth);
+        sorter->step(16);
+        world.group<Depth, Mesh>();
+        sorter->step(16);
+    }));
+
+    printf("sort_test: ok\n");
+}
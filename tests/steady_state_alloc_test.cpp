@@ -0,0 +1,132 @@
+// Once warmed up, a tick of the headless loop main.cpp runs (jobs, frame
+// allocator, huge page component arena) plus entity churn through the node
+// pools must not reach the heap. Every replaceable operator new is counted:
+// plain, array, nothrow and aligned, which is what pmr upstreams use.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include "../core/frame_loop.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static std::atomic<uint64_t> allocation_count { 0 };
+
+static void* counted_malloc(size_t size, size_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t)) return malloc(size);
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+}
+
+static void* counted_new(size_t size, size_t alignment) {
+    if (void* memory = counted_malloc(size, alignment)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return counted_new(size, 0); }
+void* operator new[](size_t size) { return counted_new(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return counted_new(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return counted_new(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, std::nothrow_t const&) noexcept { return counted_malloc(size, 0); }
+void* operator new[](size_t size, std::nothrow_t const&) noexcept { return counted_malloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept { return counted_malloc(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept { return counted_malloc(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, std::nothrow_t const&) noexcept { free(memory); }
+void operator delete[](void* memory, std::nothrow_t const&) noexcept { free(memory); }
+void operator delete(void* memory, std::align_val_t, std::nothrow_t const&) noexcept { free(memory); }
+void operator delete[](void* memory, std::align_val_t, std::nothrow_t const&) noexcept { free(memory); }
+
+struct Gravity {
+    float x, y, z;
+};
+
+struct PhysicsSystem : System {
+    void update(float dt) {
+        for (Entity entity : entities) sum += dt * static_cast<float>(entity);
+    }
+
+    float sum = 0.0f;
+};
+
+struct Snapshot {
+    std::vector<float> positions;
+};
+
+int main() {
+    // Same order as main.cpp: the arena outlives the coordinator.
+    HugePageArena component_memory (8 * HugePageArena::HUGE_PAGE_SIZE);
+    Coordinator coordinator;
+    coordinator.init();
+    coordinator.register_component<Gravity>(&component_memory);
+    auto physics_system = coordinator.register_system<PhysicsSystem>();
+    coordinator.set_system_filter<PhysicsSystem>(With<Gravity>());
+
+    std::vector<Entity> entities;
+    for (Entity i = 0; i < MAX_ENTITIES / 2; i++) {
+        Entity entity = coordinator.create_entity();
+        coordinator.add_component(entity, Gravity { 0.0f, -9.81f, 0.0f });
+        entities.push_back(entity);
+    }
+
+    JobSystem jobs;
+    JobProfile job_profile;
+    jobs.on_job_finished = [&](JobTiming const& timing) { job_profile.record(timing); };
+    LinearAllocator frame_memory (1 << 20);
+
+    size_t churn = 0;
+    auto simulate = [&](float dt) {
+        // Despawn and respawn a few entities so the system's set and the
+        // component index recycle pool nodes.
+        for (int i = 0; i < 16; i++) {
+            Entity& entity = entities[churn++ % entities.size()];
+            coordinator.destroy_entity(entity);
+            entity = coordinator.create_entity();
+            coordinator.add_component(entity, Gravity { 0.0f, -9.81f, 0.0f });
+        }
+        std::pmr::vector<Job> systems (&frame_memory);
+        systems.push_back(Job { [&] { physics_system->update(dt); }, "physics" });
+        JobCounter tick;
+        jobs.run(systems.data(), systems.size(), &tick);
+        jobs.wait(tick);
+    };
+
+    FrameLoop loop (60.0);
+    loop.frame_allocator = &frame_memory;
+    loop.run_headless(60, simulate);
+    uint64_t before = allocation_count.load();
+    loop.run_headless(2000, simulate);
+    uint64_t headless = allocation_count.load() - before;
+
+    // Pipelined frames: the simulate job plus extraction into a snapshot
+    // whose storage is reused from frame to frame.
+    DoubleBuffered<Snapshot> snapshots;
+    auto extract = [&](Snapshot& snapshot, float) {
+        snapshot.positions.assign(entities.size(), 0.0f);
+    };
+    FrameLoop pipelined (100000.0);
+    pipelined.frame_allocator = &frame_memory;
+    pipelined.start();
+    for (int i = 0; i < 60; i++) pipelined.frame(jobs, snapshots, simulate, extract, [](Snapshot const&) {});
+    before = allocation_count.load();
+    for (int i = 0; i < 2000; i++) pipelined.frame(jobs, snapshots, simulate, extract, [](Snapshot const&) {});
+    uint64_t piped = allocation_count.load() - before;
+
+    printf("steady-state allocations: %llu headless, %llu pipelined; frame memory high water %zu bytes, %zu overflows\n",
+           static_cast<unsigned long long>(headless), static_cast<unsigned long long>(piped), frame_memory.high_water, frame_memory.overflow_count);
+    assert(headless == 0 && piped == 0 && "Steady-state ticks allocated");
+    assert(frame_memory.overflow_count == 0);
+    printf("steady_state_alloc_test: ok\n");
+}
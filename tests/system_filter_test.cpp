@@ -0,0 +1,109 @@
+// System membership follows one rule however an entity gets there (adding
+// components, set_filter over existing entities, destroy): it has at least
+// one component, every With and no Without; Optional changes nothing. The
+// packed match table agrees with SystemFilter::matches for any mix of
+// systems.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+
+struct Position { float x; };
+struct Velocity { float x; };
+struct Frozen {};
+
+struct Moving : System {};
+struct Unfrozen : System {}; // Without<Frozen> only
+template<size_t N> struct Numbered : System {};
+
+template<size_t... N>
+static void register_numbered(Coordinator& world, std::index_sequence<N...>) {
+    (world.register_system<Numbered<N>>(), ...);
+}
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Position>();
+    world->register_component<Velocity>();
+    world->register_component<Frozen>();
+
+    auto moving = world->register_system<Moving>();
+    world->set_system_filter<Moving>(With<Position, Velocity>(), Without<Frozen>());
+    auto unfrozen = world->register_system<Unfrozen>();
+    world->set_system_filter<Unfrozen>(Without<Frozen>());
+
+    Entity bare = world->create_entity();
+    Entity a = world->create_entity();
+    world->add_component(a, Position {});
+    Entity b = world->create_entity();
+    world->add_component(b, Position {});
+    world->add_component(b, Velocity {});
+    assert(!unfrozen->entities.count(bare) && "Entity without components joined a system");
+    assert(unfrozen->entities.count(a) && unfrozen->entities.count(b) && "Without-only filter missed entities gaining components");
+    assert(moving->entities.size() == 1 && moving->entities.count(b));
+
+    world->add_component(b, Frozen {});
+    assert(!moving->entities.count(b) && !unfrozen->entities.count(b));
+    world->remove_component<Frozen>(b);
+    assert(moving->entities.count(b) && unfrozen->entities.count(b));
+    world->remove_component<Position>(a);
+    assert(!unfrozen->entities.count(a) && "Entity kept its membership after losing its last component");
+
+    // Re-filtering over existing entities applies the same rule.
+    world->set_system_filter<Unfrozen>(Without<Velocity>());
+    assert(unfrozen->entities.empty());
+    world->set_system_filter<Unfrozen>(Without<Frozen>());
+    assert(unfrozen->entities.size() == 1 && unfrozen->entities.count(b));
+    world->set_system_filter<Moving>(With<Position>());
+    assert(moving->entities.size() == 1 && moving->entities.count(b));
+
+    // Optional components don't gate membership; the system reads them
+    // through try_get_component.
+    world->add_component(a, Position {});
+    world->set_system_filter<Moving>(With<Position>(), Optional<Velocity>());
+    assert(moving->entities.size() == 2 && moving->entities.count(a) && moving->entities.count(b));
+    assert(!world->try_get_component<Velocity>(a) && world->try_get_component<Velocity>(b));
+    world->set_system_filter<Moving>(Optional<Velocity>());
+    assert(moving->entities.size() == 2 && "Optional-only filter should match every entity with components");
+
+    world->destroy_entities(std::vector<Entity> { a, b, bare });
+    assert(moving->entities.empty() && unfrozen->entities.empty());
+
+    // Enough systems to span two words of match bits, with random filters.
+    register_numbered(*world, std::make_index_sequence<68>());
+    SystemManager& systems = *world->system_manager;
+    std::mt19937 random (7);
+    for (size_t i = 0; i < systems.systems.size(); i++) {
+        SystemFilter filter;
+        for (ComponentType type = 0; type < MAX_COMPONENTS; type++) {
+            uint32_t roll = random() % 8;
+            if (roll == 0) filter.include.set(type);
+            if (roll == 1) filter.exclude.set(type);
+        }
+        systems.include_masks[i] = filter.include;
+        systems.exclude_masks[i] = filter.exclude;
+        for (size_t w = 0; w < Signature::WORDS; w++) {
+            systems.include_table[w][i] = filter.include.words[w];
+            systems.exclude_table[w][i] = filter.exclude.words[w];
+        }
+    }
+    std::vector<uint64_t> bits (systems.old_matches.size());
+    for (int round = 0; round < 10000; round++) {
+        Signature signature;
+        for (ComponentType type = 0; type < MAX_COMPONENTS; type++) {
+            if (random() % 3 == 0) signature.set(type);
+        }
+        if (round % 100 == 0) signature.reset();
+        systems.match_systems(signature, bits.data());
+        for (size_t i = 0; i < systems.systems.size(); i++) {
+            SystemFilter filter { systems.include_masks[i], systems.exclude_masks[i], Signature() };
+            assert(bool(bits[i / 64] >> (i % 64) & 1) == filter.matches(signature) && "Packed match disagrees with the filter");
+        }
+    }
+
+    printf("system_filter_test: ok\n");
+}
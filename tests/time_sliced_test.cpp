@@ -0,0 +1,89 @@
+// A time-sliced system resumes where the previous frame stopped and visits
+// every entity once per pass, even as entities are destroyed (also from
+// inside the update) and created mid-pass, and reports how many frames a
+// pass took. A zero budget checked after every entity makes each frame
+// process exactly one entity, which keeps the test independent of timing.
+//
+//   make test
+#include "../ecs/coordinator.hpp"
+#include "../ecs/time_sliced.hpp"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+struct Plan {
+    int visits;
+};
+
+struct Planner : TimeSlicedSystem {
+    Planner() : TimeSlicedSystem(0) {
+        check_interval = 1;
+    }
+};
+
+int main() {
+    auto world = std::make_unique<Coordinator>();
+    world->init();
+    world->register_component<Plan>();
+    auto planner = world->register_system<Planner>();
+    world->set_system_filter<Planner>(With<Plan>());
+
+    std::vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        Entity entity = world->create_entity();
+        world->add_component(entity, Plan { 0 });
+        entities.push_back(entity);
+    }
+
+    // One entity per frame: a pass over 100 takes 100 frames.
+    for (int frame = 0; frame < 100; frame++) {
+        bool finished = planner->update_sliced([&](Entity entity) { world->get_component<Plan>(entity).visits++; });
+        assert(finished == (frame == 99));
+    }
+    assert(planner->passes == 1 && planner->frames_per_pass == 100);
+    for (Entity entity : entities) assert(world->get_component<Plan>(entity).visits == 1);
+
+    // Second pass with churn: entities behind and ahead of the cursor are
+    // destroyed, one destroys itself inside f, and new ones join.
+    Entity self_destruct = entities[60];
+    std::vector<Entity> spawned;
+    std::vector<bool> destroyed (MAX_ENTITIES, false);
+    int frames = 0;
+    bool finished = false;
+    while (!finished) {
+        finished = planner->update_sliced([&](Entity entity) {
+            world->get_component<Plan>(entity).visits++;
+            if (entity == self_destruct) {
+                world->destroy_entity(entity);
+                destroyed[entity] = true;
+            }
+        });
+        frames++;
+        if (frames == 30) {
+            for (Entity entity : { entities[10], entities[80] }) {
+                world->destroy_entity(entity);
+                destroyed[entity] = true;
+            }
+            for (int i = 0; i < 5; i++) {
+                Entity entity = world->create_entity();
+                world->add_component(entity, Plan { 0 });
+                spawned.push_back(entity);
+            }
+        }
+        assert(frames <= 200 && "Pass never finished");
+    }
+    assert(planner->passes == 2 && planner->frames_per_pass == static_cast<uint32_t>(frames));
+    for (Entity entity : entities) {
+        if (destroyed[entity]) continue;
+        assert(world->get_component<Plan>(entity).visits == 2 && "Entity skipped or repeated within a pass");
+    }
+    for (Entity entity : spawned) assert(world->get_component<Plan>(entity).visits <= 1);
+
+    // A generous budget finishes a pass in one frame.
+    planner->budget_us = 1000000;
+    planner->check_interval = 16;
+    assert(planner->update_sliced([](Entity) {}));
+    assert(planner->frames_per_pass == 1);
+
+    printf("time_sliced_test: ok\n");
+}
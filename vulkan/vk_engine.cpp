@@ -393,7 +393,7 @@ void VulkanEngine::init_scene() {
     RenderObject empire;
     empire.mesh = get_mesh("empire");
     empire.material = get_material("textured_mesh");
-    empire.transform_matrix = glm::translate(glm::vec3 {5, -10, 0});
+    empire.transform.reset(glm::translate(glm::vec3 {5, -10, 0}));
 
     _renderables.push_back(empire);
 
@@ -451,6 +451,10 @@ void VulkanEngine::cleanup() {
 }
 
 void VulkanEngine::draw() {
+    draw(_renderables.data(), _renderables.size());
+}
+
+void VulkanEngine::draw(RenderObject const* objects, int count) {
     FrameData frame = get_current_frame();
     //std::cout << "Current frame: " << _frame_number % FRAME_OVERLAP << std::endl;
     error_check(vkWaitForFences(_device, 1, &get_current_frame()._render_fence, true, 1000000000));
@@ -490,7 +494,7 @@ void VulkanEngine::draw() {
     vkCmdBeginRenderPass(get_current_frame()._main_command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
     //std::cout << "Drawing command buffer for frame: " << &get_current_frame() << " with address: " << get_current_frame()._main_command_buffer << std::endl;
-    draw_objects(get_current_frame()._main_command_buffer, _renderables.data(), _renderables.size());
+    draw_objects(get_current_frame()._main_command_buffer, objects, count);
     
     vkCmdEndRenderPass(get_current_frame()._main_command_buffer);
 
@@ -605,11 +609,27 @@ void VulkanEngine::init_pipelines() {
     // <++>
 }
 
-void VulkanEngine::update() {
+void VulkanEngine::update(float alpha) {
+    _render_alpha = alpha;
     window->update();
     draw();
 }
 
+void VulkanEngine::begin_tick() {
+    for (auto& object : _renderables) object.transform.save();
+}
+
+void VulkanEngine::extract(RenderSnapshot& snapshot, float alpha) {
+    snapshot.objects.assign(_renderables.begin(), _renderables.end());
+    snapshot.alpha = alpha;
+}
+
+void VulkanEngine::update(RenderSnapshot const& snapshot) {
+    _render_alpha = snapshot.alpha;
+    window->update();
+    draw(snapshot.objects.data(), snapshot.objects.size());
+}
+
 
 bool VulkanEngine::load_shader_module(const char* file_path, VkShaderModule* out_shader_module) {
     std::ifstream file(file_path, std::ios::ate | std::ios::binary);
@@ -765,7 +785,7 @@ VkPipeline PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass pass) {
     return new_pipeline;
 }
 
-void VulkanEngine::draw_objects(VkCommandBuffer cmd, RenderObject* objects, int count) {
+void VulkanEngine::draw_objects(VkCommandBuffer cmd, RenderObject const* objects, int count) {
     glm::vec3 cam_pos = { 0.f, -3.f, -10.f };
     glm::mat4 view = glm::translate(glm::mat4(1.f), cam_pos);
     glm::mat4 projection = glm::perspective(glm::radians(70.f), 1700.f / 900.f, 0.1f, 200.f);
@@ -786,8 +806,8 @@ void VulkanEngine::draw_objects(VkCommandBuffer cmd, RenderObject* objects, int
     GPUObjectData* objectSSBO = (GPUObjectData*) object_data;
 
     for (int x = 0; x < count; x++) {
-        RenderObject& object = objects[x];
-        objectSSBO[x].model_matrix = object.transform_matrix;
+        RenderObject const& object = objects[x];
+        objectSSBO[x].model_matrix = object.transform.blend(_render_alpha);
     }
 
     vmaUnmapMemory(_allocator, get_current_frame().object_buffer._allocation);
@@ -806,7 +826,7 @@ void VulkanEngine::draw_objects(VkCommandBuffer cmd, RenderObject* objects, int
     Material* last_material = nullptr;
 
     for (int x = 0; x < count; x++) {
-        RenderObject& object = objects[x];
+        RenderObject const& object = objects[x];
         if (object.material != last_material) {
             vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, object.material->pipeline);
             last_material = object.material;
@@ -819,11 +839,11 @@ void VulkanEngine::draw_objects(VkCommandBuffer cmd, RenderObject* objects, int
                     1, 1, &get_current_frame().object_descriptor, 0, nullptr);
         }
 
-        glm::mat4 model = object.transform_matrix;
+        glm::mat4 model = object.transform.blend(_render_alpha);
         glm::mat4 mesh_matrix = projection * view * model;
 
         MeshPushConstants constants;
-        constants.render_matrix = object.transform_matrix;
+        constants.render_matrix = model;
         vkCmdPushConstants(cmd, object.material->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MeshPushConstants), &constants);
         if (object.mesh != last_mesh) {
             VkDeviceSize offset = 0;
@@ -7,6 +7,7 @@
 #include "vk_mesh.hpp"
 #include "window.hpp"
 #include "shared.hpp"
+#include "../core/frame_loop.hpp"
 
 #include <deque>
 #include <functional>
@@ -68,9 +69,17 @@ struct RenderObject {
     Mesh* mesh;
     Material* material;
 
-    glm::mat4 transform_matrix;
+    // Simulation writes current; begin_tick saves it as previous and draws
+    // blend the two by _render_alpha.
+    Interpolated<glm::mat4> transform;
 };
 
+// Everything render reads from the simulation, copied out at a sync point so
+// the next ticks can run while it's drawn.
+struct RenderSnapshot {
+    std::vector<RenderObject> objects;
+    float alpha = 1.0f;
+};
 
 struct PipelineBuilder {
     std::vector<VkPipelineShaderStageCreateInfo> _shader_stages;
@@ -112,6 +121,7 @@ struct VulkanEngine {
 
     bool _is_initialized = false;
     int _frame_number = 0;
+    float _render_alpha = 1.0f;
     VkExtent2D _window_extent = { 1700, 900 };
 
 
@@ -168,7 +178,7 @@ struct VulkanEngine {
     bool load_shader_module(const char* file_path, VkShaderModule* out_shader_module);
     void load_meshes();
     void upload_mesh(Mesh& mesh);
-    void draw_objects(VkCommandBuffer cmd, RenderObject* first, int count);
+    void draw_objects(VkCommandBuffer cmd, RenderObject const* first, int count);
     void immediate_submit(std::function<void(VkCommandBuffer cmd)>&& function);
     size_t pad_uniform_buffer_size(size_t original_size);
     void load_images();
@@ -181,6 +191,15 @@ struct VulkanEngine {
     void init();
     void cleanup();
     void draw();
-    void update();
+    void draw(RenderObject const* objects, int count);
+    void update(float alpha = 1.0f);
+
+    // Pipelined rendering: extract copies the renderables out, update draws a
+    // copy without touching _renderables.
+    void extract(RenderSnapshot& snapshot, float alpha);
+
+    // Call at the start of every simulation tick, before anything moves.
+    void begin_tick();
+    void update(RenderSnapshot const& snapshot);
 
 };